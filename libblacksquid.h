@@ -90,6 +90,8 @@ void arena_free(Arena *a);
 #define LIBBLACKSQUID_H
 #pragma once
 
+#include <stdarg.h>
+
 typedef enum ltbs_type ltbs_type;
 typedef struct ltbs_cell ltbs_cell;
 typedef struct ltbs_string ltbs_string;
@@ -97,14 +99,55 @@ typedef struct ltbs_array ltbs_array;
 typedef struct ltbs_pair ltbs_pair;
 // based on https://nullprogram.com/blog/2023/09/30/
 typedef struct ltbs_hashmap ltbs_hashmap;
+typedef struct ltbs_flatmap ltbs_flatmap;
+typedef struct ltbs_flat_slot ltbs_flat_slot;
+typedef struct ltbs_hash_iter ltbs_hash_iter;
 typedef struct ltbs_keyvaluepair ltbs_keyvaluepair;
+typedef struct ltbs_string_builder ltbs_string_builder;
+typedef struct ltbs_rope ltbs_rope;
+typedef struct ltbs_rope_iter ltbs_rope_iter;
+typedef struct ltbs_split_iter ltbs_split_iter;
+typedef struct ltbs_byteset ltbs_byteset;
+typedef struct ltbs_intern_table ltbs_intern_table;
+typedef struct ltbs_mapped_file ltbs_mapped_file;
+typedef struct ltbs_file_reader ltbs_file_reader;
+typedef struct ltbs_template ltbs_template;
+typedef struct ltbs_template_segment ltbs_template_segment;
+typedef struct ltbs_template_cache ltbs_template_cache;
+typedef struct ltbs_json_status ltbs_json_status;
+typedef struct ltbs_utf8_iter ltbs_utf8_iter;
+typedef struct ltbs_matcher ltbs_matcher;
+typedef struct ltbs_match_stream ltbs_match_stream;
 typedef int (*compare_fn)(ltbs_cell*, ltbs_cell*);
 typedef int (*pred_fn)(ltbs_cell*);
 typedef char byte;
 typedef ltbs_cell *(*transform_fn)(ltbs_cell *cell, Arena *context);
 typedef void (*callback_fn)(ltbs_cell *cell, void *param);
-
-#define HASH_FACTOR 1111111111111111111u
+typedef void (*entry_fn)(ltbs_cell *key, ltbs_cell *value, void *param);
+typedef void (*chunk_fn)(const byte *chunk, size_t length, void *param);
+typedef void (*match_fn)(size_t pattern, size_t start, size_t end, void *param);
+
+// Seed of hash_compute(); define it before including this file to give
+// a program its own hash function.
+#ifndef LTBS_HASH_SEED
+#define LTBS_HASH_SEED 0x9E3779B97F4A7C15ULL
+#endif
+#define ROPE_MAX_HEIGHT 96
+
+// ltbs_string flags: HASHED means `hash` holds hash_compute() of the
+// bytes (hash_mix64() of the value for integer hashmap keys), INTERNED
+// strings are canonical and always HASHED as well. INLINE strings keep
+// their bytes and terminator in the cell itself. INT_KEY and UINT_KEY
+// mark the 8 raw bytes a hashmap stores for an integer key, so that
+// writers print the number instead.
+#define LTBS_STRING_INTERNED 1
+#define LTBS_STRING_HASHED 2
+#define LTBS_STRING_INLINE 4
+#define LTBS_STRING_INT_KEY 8
+#define LTBS_STRING_UINT_KEY 16
+
+// Fits in the space the hashmap member already reserves in the union.
+#define LTBS_STRING_INLINE_CAPACITY 16
 
 #define pair_iterate(to_iter, head, tracker, ...) { for ( ltbs_cell *tracker = to_iter; pair_head(tracker); tracker = pair_rest(tracker) ) { ltbs_cell *head = pair_head(tracker); __VA_ARGS__ } } 
 
@@ -136,7 +179,9 @@ struct ltbs_cell
 	LTBS_ARRAY,
 	LTBS_PAIR,
 	LTBS_HASHMAP,
-	LTBS_CUSTOM
+	LTBS_CUSTOM,
+	LTBS_ROPE,
+	LTBS_FLATMAP
     } type;
 
     union
@@ -152,10 +197,17 @@ struct ltbs_cell
 	    ltbs_cell *rest;
 	} pair;
 	
+	// Interned strings are immutable and carry their hash. Short
+	// strings point `strdata` at `inline_data`, so they cost one
+	// allocation and every reader can ignore the difference. A copy
+	// made by value keeps reading the original cell's bytes.
 	struct ltbs_string
 	{
 	    byte *strdata;
 	    unsigned int length;
+	    unsigned int flags;
+	    uint64_t hash;
+	    byte inline_data[LTBS_STRING_INLINE_CAPACITY];
 	} string;
 	
 	struct ltbs_array
@@ -165,18 +217,37 @@ struct ltbs_cell
 	    size_t total_size;
 	} array;
 
+	// The root of a map never holds an entry, so it keeps the
+	// number of entries below it where a value would be.
 	struct ltbs_hashmap
 	{
 	    ltbs_cell *children[4];
 	    ltbs_cell *key;
-	    ltbs_cell *value;
+	    union
+	    {
+		ltbs_cell *value;
+		size_t count;
+	    };
 	} hashmap;
 
+	ltbs_flatmap *flatmap;
+
         struct
 	{
 	    void *data;
 	    size_t size;
 	} custom;
+
+	// Leaves have no children and point at their bytes, inner
+	// nodes only cache the total length and their AVL height.
+	struct ltbs_rope
+	{
+	    ltbs_cell *left;
+	    ltbs_cell *right;
+	    byte *strdata;
+	    size_t length;
+	    unsigned int height;
+	} rope;
     } data;
 };
 
@@ -208,11 +279,23 @@ struct ltbs_list_vt
 
 extern struct ltbs_list_vt List_Vt;
 
+// Owns the memory behind the strings returned by string_map_file() and
+// string_map_file_views(). On POSIX systems it is a read-only mapping of
+// the whole file; elsewhere the file is read into a malloc()ed buffer.
+// Release it with string_unmap_file() once no view into it is in use.
+struct ltbs_mapped_file
+{
+    void *base;
+    size_t length;
+    int is_mapped;
+};
+
 struct ltbs_string_vt
 {
     ltbs_cell *(*cs)(const char *cstring, Arena *context);
     ltbs_cell *(*substring)(ltbs_cell *string, unsigned int start, unsigned int end, Arena *context);
     int (*compare)(ltbs_cell *string1, ltbs_cell *string2);
+    int (*compare_nocase)(ltbs_cell *string1, ltbs_cell *string2);
     ltbs_cell *(*append)(ltbs_cell *string1, ltbs_cell *string2, Arena *context);
     ltbs_cell *(*to_list)(ltbs_cell *string, Arena *context);
     ltbs_cell *(*reverse)(ltbs_cell *string, Arena *context);
@@ -223,10 +306,210 @@ struct ltbs_string_vt
     ltbs_cell *(*format)(Arena *context, const char *fmt, ...);
     ltbs_cell *(*from_file)(const char *path, Arena *context);
     int (*is_suffix)(ltbs_cell *string, ltbs_cell *suffix);
+    ltbs_split_iter (*split_iter)(ltbs_cell *string, byte splitter);
+    ltbs_split_iter (*split_multi_iter)(ltbs_cell *string, ltbs_cell *splitter);
+    int (*split_next)(ltbs_split_iter *iter, ltbs_cell *token);
+    ltbs_cell *(*split_collect)(ltbs_split_iter iter, Arena *context);
+    int64_t (*find)(ltbs_cell *string, ltbs_cell *needle, size_t start);
+    int64_t (*rfind)(ltbs_cell *string, ltbs_cell *needle);
+    ltbs_cell *(*find_all)(ltbs_cell *string, ltbs_cell *needle, Arena *context);
+    size_t (*count)(ltbs_cell *string, ltbs_cell *needle);
+    ltbs_cell *(*replace)(ltbs_cell *string, ltbs_cell *needle, ltbs_cell *replacement, Arena *context);
+    ltbs_cell *(*map_file)(const char *path, ltbs_mapped_file *handle, Arena *context);
+    ltbs_cell *(*map_file_views)(const char *path, ltbs_mapped_file *handle, size_t limit, Arena *context);
+    void (*unmap_file)(ltbs_mapped_file *handle);
+    ltbs_cell *(*upcase)(ltbs_cell *string, Arena *context);
+    ltbs_cell *(*downcase)(ltbs_cell *string, Arena *context);
+    void (*upcase_in_place)(ltbs_cell *string);
+    void (*downcase_in_place)(ltbs_cell *string);
+    void (*trim)(ltbs_cell *string, ltbs_cell *view);
+    int (*to_int)(ltbs_cell *string, int64_t *out);
+    int (*to_uint)(ltbs_cell *string, uint64_t *out);
+    int (*to_double)(ltbs_cell *string, double *out);
+    ltbs_cell *(*from_int)(int64_t value, Arena *context);
+    ltbs_cell *(*from_uint)(uint64_t value, Arena *context);
+    ltbs_cell *(*from_double)(double value, Arena *context);
 };
 
 extern struct ltbs_string_vt String_Vt;
 
+// Reads a file through one fixed buffer allocated from an Arena, so a
+// file of any size is processed in constant memory. Lines and chunks
+// are handed out as views into that buffer and stay valid only until
+// the next call on the same reader. The buffer only grows, by doubling,
+// when a single line does not fit in it.
+struct ltbs_file_reader
+{
+    void *file;
+    Arena *context;
+    byte *buffer;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    int eof;
+};
+
+struct ltbs_reader_vt
+{
+    ltbs_file_reader *(*open)(const char *path, size_t chunk_size, Arena *context);
+    int (*next_line)(ltbs_file_reader *reader, ltbs_cell *line);
+    int (*next_chunk)(ltbs_file_reader *reader, ltbs_cell *chunk);
+    void (*close)(ltbs_file_reader *reader);
+};
+
+extern struct ltbs_reader_vt Reader_Vt;
+
+// A precompiled set of byte values. `bits` is the plain 256-bit table;
+// `nibbles` holds the same set split by high nibble, where bit (h & 7)
+// of nibbles[h >> 3][l] is set for every member (h << 4) | l. The second
+// form lets SIMD code classify 16 or 32 bytes with two table shuffles.
+struct ltbs_byteset
+{
+    uint64_t bits[4];
+    uint8_t nibbles[2][16];
+};
+
+struct ltbs_byteset_vt
+{
+    ltbs_byteset (*from_string)(ltbs_cell *members);
+    int (*contains)(ltbs_byteset *set, byte value);
+    size_t (*find)(ltbs_byteset *set, ltbs_cell *string, size_t start);
+    size_t (*skip)(ltbs_byteset *set, ltbs_cell *string, size_t start);
+};
+
+extern struct ltbs_byteset_vt Byteset_Vt;
+
+// Walks the tokens of a string without allocating; every token is a
+// view into the original bytes. The single splitter variant keeps empty
+// tokens like string_split(), the multi variant skips them like
+// string_split_multi().
+struct ltbs_split_iter
+{
+    byte *cursor;
+    byte *end;
+    ltbs_byteset splitters;
+    byte splitter;
+    int multi;
+    int done;
+};
+
+// Growable byte buffer living at the top of an Arena. While nothing
+// else is allocated from the same arena the buffer doubles in place,
+// and finish() hands the bytes over as an ltbs_string without a copy.
+struct ltbs_string_builder
+{
+    Arena *context;
+    byte *buffer;
+    size_t length;
+    size_t capacity;
+};
+
+struct ltbs_builder_vt
+{
+    ltbs_string_builder (*new)(size_t capacity, Arena *context);
+    void (*reserve)(ltbs_string_builder *builder, size_t additional);
+    void (*append_bytes)(ltbs_string_builder *builder, const byte *bytes, size_t length);
+    void (*append_byte)(ltbs_string_builder *builder, byte value);
+    void (*append_cs)(ltbs_string_builder *builder, const char *cstring);
+    void (*append_cell)(ltbs_string_builder *builder, ltbs_cell *cell);
+    void (*append_int)(ltbs_string_builder *builder, int64_t value);
+    void (*append_uint)(ltbs_string_builder *builder, uint64_t value);
+    void (*append_float)(ltbs_string_builder *builder, double value);
+    void (*append_format)(ltbs_string_builder *builder, const char *fmt, ...);
+    ltbs_cell *(*finish)(ltbs_string_builder *builder);
+};
+
+extern struct ltbs_builder_vt Builder_Vt;
+
+// Walks the code points of a UTF-8 string.
+struct ltbs_utf8_iter
+{
+    byte *cursor;
+    byte *end;
+};
+
+struct ltbs_utf8_vt
+{
+    int (*validate)(ltbs_cell *string);
+    size_t (*count)(ltbs_cell *string);
+    ltbs_utf8_iter (*iter)(ltbs_cell *string);
+    int (*next)(ltbs_utf8_iter *iter, uint32_t *codepoint);
+    ltbs_cell *(*to_utf32)(ltbs_cell *string, Arena *context);
+    ltbs_cell *(*from_utf32)(ltbs_cell *codepoints, Arena *context);
+};
+
+extern struct ltbs_utf8_vt Utf8_Vt;
+
+// Matcher options: NOCASE folds ASCII letters, WHOLE_WORDS drops
+// matches that begin or end in the middle of a word.
+#define LTBS_MATCH_NOCASE 1
+#define LTBS_MATCH_WHOLE_WORDS 2
+
+// Aho-Corasick automaton for a list of patterns, compiled to a full DFA
+// so a scan is one table load per byte. Bytes are first mapped to
+// classes, one per distinct pattern byte and one for all the others,
+// which keeps a row `class_count` wide instead of 256. WHOLE_WORDS adds
+// one class that the scanner feeds at the start of every word.
+struct ltbs_matcher
+{
+    uint32_t *transitions;
+    uint32_t *output;
+    uint32_t *report;
+    uint32_t *report_next;
+    size_t *pattern_lengths;
+    size_t pattern_count;
+    uint32_t state_count;
+    uint32_t class_count;
+    int options;
+    uint16_t classes[256];
+};
+
+// Scan state carried between chunks of one input.
+struct ltbs_match_stream
+{
+    ltbs_matcher *matcher;
+    uint32_t state;
+    size_t offset;
+    int in_word;
+};
+
+struct ltbs_matcher_vt
+{
+    ltbs_matcher *(*compile)(ltbs_cell *patterns, int options, Arena *context);
+    size_t (*find_all)(ltbs_matcher *matcher, ltbs_cell *string, match_fn callback, void *param);
+    ltbs_match_stream (*stream)(ltbs_matcher *matcher);
+    size_t (*feed)(ltbs_match_stream *stream, const byte *bytes, size_t length, match_fn callback, void *param);
+    size_t (*finish)(ltbs_match_stream *stream, match_fn callback, void *param);
+};
+
+extern struct ltbs_matcher_vt Matcher_Vt;
+
+// Immutable balanced tree of string chunks. Every operation returns a
+// new rope sharing structure with its inputs; the empty rope is 0.
+struct ltbs_rope_iter
+{
+    ltbs_cell *stack[ROPE_MAX_HEIGHT];
+    int top;
+};
+
+struct ltbs_rope_vt
+{
+    ltbs_cell *(*from_string)(ltbs_cell *string, Arena *context);
+    size_t (*length)(ltbs_cell *rope);
+    ltbs_cell *(*concat)(ltbs_cell *rope1, ltbs_cell *rope2, Arena *context);
+    void (*split)(ltbs_cell *rope, size_t index, ltbs_cell **left, ltbs_cell **right, Arena *context);
+    ltbs_cell *(*insert)(ltbs_cell *rope, size_t index, ltbs_cell *to_insert, Arena *context);
+    ltbs_cell *(*remove)(ltbs_cell *rope, size_t start, size_t end, Arena *context);
+    ltbs_cell *(*substring)(ltbs_cell *rope, size_t start, size_t end, Arena *context);
+    byte (*at_index)(ltbs_cell *rope, size_t index);
+    ltbs_rope_iter (*iter)(ltbs_cell *rope);
+    int (*next)(ltbs_rope_iter *iter, ltbs_cell *chunk);
+    void (*for_each)(ltbs_cell *rope, chunk_fn callback, void *param);
+    ltbs_cell *(*flatten)(ltbs_cell *rope, Arena *context);
+};
+
+extern struct ltbs_rope_vt Rope_Vt;
+
 struct ltbs_array_vt
 {
     ltbs_cell *(*new_array)(size_t elem_size, size_t total_size, Arena *context);
@@ -245,17 +528,197 @@ struct ltbs_array_vt
 
 extern struct ltbs_array_vt Array_Vt;
 
+// Walks the entries of either engine without allocating. Below the
+// 32nd trie level the hash is used up and only first children exist, so
+// at most three siblings per level wait on the stack.
+#define LTBS_HASH_ITER_STACK (3 * 32 + 4)
+
+struct ltbs_hash_iter
+{
+    ltbs_cell *map;
+    size_t index;
+    size_t top;
+    ltbs_cell *stack[LTBS_HASH_ITER_STACK];
+};
+
+// Maps come from Hash_Vt.new or Flat_Vt.new, but a null map also works
+// as an empty trie: the first insertion allocates its root.
 struct ltbs_hashmap_vt
 {
     ltbs_cell *(*new)(Arena *context);
     ltbs_cell *(*upsert)(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
     uint64_t (*compute)(ltbs_string *key);
+    uint64_t (*compute_nocase)(ltbs_string *key);
+    uint64_t (*bytes)(const void *bytes, size_t length, uint64_t seed);
     ltbs_cell *(*lookup)(ltbs_cell **map, byte *cstring);
     ltbs_cell *(*keys)(ltbs_cell **map, Arena *context);
+    ltbs_cell *(*lookup_bytes)(ltbs_cell **map, const byte *bytes, size_t length);
+    ltbs_cell *(*lookup_view)(ltbs_cell **map, ltbs_cell *key);
+    ltbs_cell *(*lookup_hashed)(ltbs_cell **map, const byte *bytes, size_t length, uint64_t hash);
+    ltbs_cell *(*adopt)(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*remove)(ltbs_cell **map, ltbs_cell *key);
+    size_t (*count)(ltbs_cell **map);
+    void (*clear)(ltbs_cell **map);
+    uint64_t (*mix64)(uint64_t value);
+    ltbs_cell *(*upsert_bytes)(ltbs_cell **map, const void *key, size_t size, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*remove_bytes)(ltbs_cell **map, const void *key, size_t size);
+    ltbs_cell *(*upsert_int)(ltbs_cell **map, int64_t key, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*lookup_int)(ltbs_cell **map, int64_t key);
+    ltbs_cell *(*remove_int)(ltbs_cell **map, int64_t key);
+    ltbs_cell *(*upsert_uint)(ltbs_cell **map, uint64_t key, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*lookup_uint)(ltbs_cell **map, uint64_t key);
+    ltbs_cell *(*remove_uint)(ltbs_cell **map, uint64_t key);
+    int64_t (*key_int)(ltbs_cell *key);
+    uint64_t (*key_uint)(ltbs_cell *key);
+    ltbs_hash_iter (*iter)(ltbs_cell **map);
+    int (*next)(ltbs_hash_iter *iter, ltbs_cell **key, ltbs_cell **value);
+    ltbs_cell *(*values)(ltbs_cell **map, Arena *context);
+    ltbs_cell *(*entries)(ltbs_cell **map, Arena *context);
+    void (*for_each)(ltbs_cell **map, entry_fn callback, void *param);
 };
 
 extern struct ltbs_hashmap_vt Hash_Vt;
 
+// An open-addressing map in the Swiss table style, for large maps read
+// far more often than written. Every slot has a control byte that is
+// EMPTY, DELETED or the low 7 bits of its key's hash, and a lookup
+// compares a whole group of 16 of those before touching any key. The
+// first group is mirrored past the end so no group load wraps. Lives in
+// an LTBS_FLATMAP cell and every Hash_Vt function accepts one.
+struct ltbs_flat_slot
+{
+    ltbs_cell *key;
+    ltbs_cell *value;
+};
+
+struct ltbs_flatmap
+{
+    int8_t *control;
+    ltbs_flat_slot *slots;
+    size_t capacity;
+    size_t count;
+    size_t deleted;
+};
+
+struct ltbs_flatmap_vt
+{
+    ltbs_cell *(*new)(size_t capacity, Arena *context);
+    void (*reserve)(ltbs_cell **map, size_t count, Arena *context);
+};
+
+extern struct ltbs_flatmap_vt Flat_Vt;
+
+// Lock-free access to a trie made by Hash_Vt.new, for threads filling a
+// shared map. Each thread passes its own arena, new nodes are published
+// with a compare-and-swap on the empty child slot, and values are
+// replaced atomically. A node that loses the race stays in its thread's
+// arena. Removal and clearing are not safe while other threads use the
+// map; once they are joined every Hash_Vt function works on it again.
+struct ltbs_concurrent_vt
+{
+    ltbs_cell *(*upsert)(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*insert)(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*lookup)(ltbs_cell **map, ltbs_cell *key);
+    int (*replace)(ltbs_cell **map, ltbs_cell *key, ltbs_cell *expected, ltbs_cell *desired);
+};
+
+extern struct ltbs_concurrent_vt Concurrent_Vt;
+
+// Updates to a trie that leave the map they are given untouched and
+// return a new root instead, copying only the nodes on the path to the
+// change. Every old root stays a valid snapshot, readable with the
+// Hash_Vt lookups and iterators, and may be handed to other threads once
+// published. The mutating Hash_Vt functions must not be used on shared
+// roots. A null map is an empty trie, as elsewhere; Flat_Vt maps have no
+// paths to copy and are refused with a null result.
+struct ltbs_persistent_vt
+{
+    ltbs_cell *(*upsert)(ltbs_cell *map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+    ltbs_cell *(*remove)(ltbs_cell *map, ltbs_cell *key, Arena *context);
+};
+
+extern struct ltbs_persistent_vt Persistent_Vt;
+
+// Maps byte sequences to one canonical string each, kept in a single
+// long-lived arena. Equal interned strings are pointer-equal.
+struct ltbs_intern_table
+{
+    ltbs_cell *map;
+    Arena *context;
+    size_t count;
+};
+
+struct ltbs_intern_vt
+{
+    ltbs_intern_table *(*new)(Arena *context);
+    ltbs_cell *(*intern)(ltbs_intern_table *table, ltbs_cell *string);
+    ltbs_cell *(*bytes)(ltbs_intern_table *table, const byte *bytes, size_t length);
+    ltbs_cell *(*cs)(ltbs_intern_table *table, const char *cstring);
+    size_t (*count)(ltbs_intern_table *table);
+};
+
+extern struct ltbs_intern_vt Intern_Vt;
+
+// A {{key}} template compiled into literal text runs, each followed by
+// the placeholder to substitute after it. Keys carry their hash, so a
+// render costs one trie walk per placeholder and no parsing.
+struct ltbs_template_segment
+{
+    ltbs_cell text;
+    ltbs_cell *key;
+};
+
+struct ltbs_template
+{
+    ltbs_template_segment *segments;
+    size_t count;
+    size_t literal_length;
+};
+
+// Compiled templates keyed by their source text.
+struct ltbs_template_cache
+{
+    ltbs_cell *map;
+    Arena *context;
+};
+
+struct ltbs_template_vt
+{
+    ltbs_template *(*compile)(const char *format, Arena *context);
+    ltbs_cell *(*render)(ltbs_template *compiled, ltbs_cell *data_map, Arena *context);
+    void (*render_into)(ltbs_template *compiled, ltbs_cell *data_map, ltbs_string_builder *builder);
+    void (*append_value)(ltbs_string_builder *builder, ltbs_cell *value);
+    ltbs_template_cache *(*cache_new)(Arena *context);
+    ltbs_template *(*cache_get)(ltbs_template_cache *cache, const char *format);
+};
+
+extern struct ltbs_template_vt Template_Vt;
+
+// JSON options: PRETTY and CANONICAL for the writer, ARRAYS makes the
+// parser build arrays of cells instead of lists.
+#define LTBS_JSON_PRETTY 1
+#define LTBS_JSON_CANONICAL 2
+#define LTBS_JSON_ARRAYS 4
+
+// Result of Json_Vt.parse(): on failure `offset` is the byte where the
+// error was found and `message` describes it.
+struct ltbs_json_status
+{
+    int ok;
+    size_t offset;
+    const char *message;
+};
+
+struct ltbs_json_vt
+{
+    ltbs_cell *(*serialize)(ltbs_cell *value, int options, Arena *context);
+    void (*write)(ltbs_string_builder *builder, ltbs_cell *value, int options);
+    int (*write_fd)(int fd, ltbs_cell *value, int options, Arena *context);
+    ltbs_cell *(*parse)(ltbs_cell *text, int options, Arena *context, ltbs_json_status *status);
+};
+
+extern struct ltbs_json_vt Json_Vt;
+
 #endif // LIBBLACKSQUID_H
 
 /* #define LIBBLACKSQUID_IMPLEMENTATION */
@@ -308,6 +771,7 @@ struct ltbs_list_vt List_Vt = (struct ltbs_list_vt)
 ltbs_cell *string_from_cstring(const char *cstring, Arena *context);
 ltbs_cell *string_substring(ltbs_cell *string, unsigned int start, unsigned int end, Arena *context);
 int string_compare(ltbs_cell *string1, ltbs_cell *string2);
+int string_compare_nocase(ltbs_cell *string1, ltbs_cell *string2);
 ltbs_cell *string_append(ltbs_cell *string1, ltbs_cell *string2, Arena *context);
 ltbs_cell *string_to_list(ltbs_cell *string, Arena *context);
 ltbs_cell *string_reverse(ltbs_cell *string, Arena *context);
@@ -318,12 +782,36 @@ ltbs_cell *string_split_multi(ltbs_cell *string, ltbs_cell *splitter, Arena *con
 ltbs_cell *string_format(Arena *context, const char *fmt, ...);
 ltbs_cell *string_from_file(const char *filepath, Arena *context);
 int string_is_suffix(ltbs_cell *string, ltbs_cell *suffix);
+ltbs_split_iter string_split_iter(ltbs_cell *string, byte splitter);
+ltbs_split_iter string_split_multi_iter(ltbs_cell *string, ltbs_cell *splitter);
+int string_split_next(ltbs_split_iter *iter, ltbs_cell *token);
+ltbs_cell *string_split_collect(ltbs_split_iter iter, Arena *context);
+int64_t string_find(ltbs_cell *string, ltbs_cell *needle, size_t start);
+int64_t string_rfind(ltbs_cell *string, ltbs_cell *needle);
+ltbs_cell *string_find_all(ltbs_cell *string, ltbs_cell *needle, Arena *context);
+size_t string_count(ltbs_cell *string, ltbs_cell *needle);
+ltbs_cell *string_replace(ltbs_cell *string, ltbs_cell *needle, ltbs_cell *replacement, Arena *context);
+ltbs_cell *string_map_file(const char *filepath, ltbs_mapped_file *handle, Arena *context);
+ltbs_cell *string_map_file_views(const char *filepath, ltbs_mapped_file *handle, size_t limit, Arena *context);
+void string_unmap_file(ltbs_mapped_file *handle);
+ltbs_cell *string_upcase(ltbs_cell *string, Arena *context);
+ltbs_cell *string_downcase(ltbs_cell *string, Arena *context);
+void string_upcase_in_place(ltbs_cell *string);
+void string_downcase_in_place(ltbs_cell *string);
+void string_trim(ltbs_cell *string, ltbs_cell *view);
+int string_to_int(ltbs_cell *string, int64_t *out);
+int string_to_uint(ltbs_cell *string, uint64_t *out);
+int string_to_double(ltbs_cell *string, double *out);
+ltbs_cell *int_to_string(int64_t value, Arena *context);
+ltbs_cell *uint_to_string(uint64_t value, Arena *context);
+ltbs_cell *double_to_string(double value, Arena *context);
 
 struct ltbs_string_vt String_Vt = (struct ltbs_string_vt)
 {
     .cs = string_from_cstring,
     .substring = string_substring,
     .compare = string_compare,
+    .compare_nocase = string_compare_nocase,
     .append = string_append,
     .to_list = string_to_list,
     .reverse = string_reverse,
@@ -334,6 +822,144 @@ struct ltbs_string_vt String_Vt = (struct ltbs_string_vt)
     .format = string_format,
     .from_file = string_from_file,
     .is_suffix = string_is_suffix,
+    .split_iter = string_split_iter,
+    .split_multi_iter = string_split_multi_iter,
+    .split_next = string_split_next,
+    .split_collect = string_split_collect,
+    .find = string_find,
+    .rfind = string_rfind,
+    .find_all = string_find_all,
+    .count = string_count,
+    .replace = string_replace,
+    .map_file = string_map_file,
+    .map_file_views = string_map_file_views,
+    .unmap_file = string_unmap_file,
+    .upcase = string_upcase,
+    .downcase = string_downcase,
+    .upcase_in_place = string_upcase_in_place,
+    .downcase_in_place = string_downcase_in_place,
+    .trim = string_trim,
+    .to_int = string_to_int,
+    .to_uint = string_to_uint,
+    .to_double = string_to_double,
+    .from_int = int_to_string,
+    .from_uint = uint_to_string,
+    .from_double = double_to_string,
+};
+
+int utf8_validate(ltbs_cell *string);
+size_t utf8_count(ltbs_cell *string);
+ltbs_utf8_iter utf8_iter(ltbs_cell *string);
+int utf8_next(ltbs_utf8_iter *iter, uint32_t *codepoint);
+ltbs_cell *utf8_to_utf32(ltbs_cell *string, Arena *context);
+ltbs_cell *utf8_from_utf32(ltbs_cell *codepoints, Arena *context);
+
+struct ltbs_utf8_vt Utf8_Vt = (struct ltbs_utf8_vt)
+{
+    .validate = utf8_validate,
+    .count = utf8_count,
+    .iter = utf8_iter,
+    .next = utf8_next,
+    .to_utf32 = utf8_to_utf32,
+    .from_utf32 = utf8_from_utf32,
+};
+
+ltbs_matcher *matcher_compile(ltbs_cell *patterns, int options, Arena *context);
+size_t matcher_find_all(ltbs_matcher *matcher, ltbs_cell *string, match_fn callback, void *param);
+ltbs_match_stream matcher_stream(ltbs_matcher *matcher);
+size_t matcher_feed(ltbs_match_stream *stream, const byte *bytes, size_t length, match_fn callback, void *param);
+size_t matcher_finish(ltbs_match_stream *stream, match_fn callback, void *param);
+
+struct ltbs_matcher_vt Matcher_Vt = (struct ltbs_matcher_vt)
+{
+    .compile = matcher_compile,
+    .find_all = matcher_find_all,
+    .stream = matcher_stream,
+    .feed = matcher_feed,
+    .finish = matcher_finish,
+};
+
+ltbs_file_reader *reader_open(const char *filepath, size_t chunk_size, Arena *context);
+int reader_next_line(ltbs_file_reader *reader, ltbs_cell *line);
+int reader_next_chunk(ltbs_file_reader *reader, ltbs_cell *chunk);
+void reader_close(ltbs_file_reader *reader);
+
+struct ltbs_reader_vt Reader_Vt = (struct ltbs_reader_vt)
+{
+    .open = reader_open,
+    .next_line = reader_next_line,
+    .next_chunk = reader_next_chunk,
+    .close = reader_close,
+};
+
+ltbs_byteset byteset_from_string(ltbs_cell *members);
+int byteset_contains(ltbs_byteset *set, byte value);
+size_t byteset_find(ltbs_byteset *set, ltbs_cell *string, size_t start);
+size_t byteset_skip(ltbs_byteset *set, ltbs_cell *string, size_t start);
+
+struct ltbs_byteset_vt Byteset_Vt = (struct ltbs_byteset_vt)
+{
+    .from_string = byteset_from_string,
+    .contains = byteset_contains,
+    .find = byteset_find,
+    .skip = byteset_skip,
+};
+
+ltbs_string_builder builder_new(size_t capacity, Arena *context);
+void builder_reserve(ltbs_string_builder *builder, size_t additional);
+void builder_append_bytes(ltbs_string_builder *builder, const byte *bytes, size_t length);
+void builder_append_byte(ltbs_string_builder *builder, byte value);
+void builder_append_cstring(ltbs_string_builder *builder, const char *cstring);
+void builder_append_cell(ltbs_string_builder *builder, ltbs_cell *cell);
+void builder_append_int(ltbs_string_builder *builder, int64_t value);
+void builder_append_uint(ltbs_string_builder *builder, uint64_t value);
+void builder_append_float(ltbs_string_builder *builder, double value);
+void builder_append_format(ltbs_string_builder *builder, const char *fmt, ...);
+void builder_append_formatv(ltbs_string_builder *builder, const char *fmt, va_list arguments);
+ltbs_cell *builder_finish(ltbs_string_builder *builder);
+
+struct ltbs_builder_vt Builder_Vt = (struct ltbs_builder_vt)
+{
+    .new = builder_new,
+    .reserve = builder_reserve,
+    .append_bytes = builder_append_bytes,
+    .append_byte = builder_append_byte,
+    .append_cs = builder_append_cstring,
+    .append_cell = builder_append_cell,
+    .append_int = builder_append_int,
+    .append_uint = builder_append_uint,
+    .append_float = builder_append_float,
+    .append_format = builder_append_format,
+    .finish = builder_finish,
+};
+
+ltbs_cell *rope_from_string(ltbs_cell *string, Arena *context);
+size_t rope_length(ltbs_cell *rope);
+ltbs_cell *rope_concat(ltbs_cell *rope1, ltbs_cell *rope2, Arena *context);
+void rope_split(ltbs_cell *rope, size_t index, ltbs_cell **left, ltbs_cell **right, Arena *context);
+ltbs_cell *rope_insert(ltbs_cell *rope, size_t index, ltbs_cell *to_insert, Arena *context);
+ltbs_cell *rope_remove(ltbs_cell *rope, size_t start, size_t end, Arena *context);
+ltbs_cell *rope_substring(ltbs_cell *rope, size_t start, size_t end, Arena *context);
+byte rope_at_index(ltbs_cell *rope, size_t index);
+ltbs_rope_iter rope_iter(ltbs_cell *rope);
+int rope_next(ltbs_rope_iter *iter, ltbs_cell *chunk);
+void rope_for_each(ltbs_cell *rope, chunk_fn callback, void *param);
+ltbs_cell *rope_flatten(ltbs_cell *rope, Arena *context);
+
+struct ltbs_rope_vt Rope_Vt = (struct ltbs_rope_vt)
+{
+    .from_string = rope_from_string,
+    .length = rope_length,
+    .concat = rope_concat,
+    .split = rope_split,
+    .insert = rope_insert,
+    .remove = rope_remove,
+    .substring = rope_substring,
+    .at_index = rope_at_index,
+    .iter = rope_iter,
+    .next = rope_next,
+    .for_each = rope_for_each,
+    .flatten = rope_flatten,
 };
 
 ltbs_cell *array_to_list(ltbs_cell *array, Arena *context);
@@ -360,26 +986,165 @@ struct ltbs_array_vt Array_Vt = (struct ltbs_array_vt)
 ltbs_cell *hash_make(Arena *context);
 ltbs_cell *hash_upsert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
 uint64_t hash_compute(ltbs_string *key);
+uint64_t hash_compute_nocase(ltbs_string *key);
+uint64_t hash_bytes(const void *bytes, size_t length, uint64_t seed);
 ltbs_cell *hash_lookup(ltbs_cell **map, byte *cstring);
 ltbs_cell *hash_keys(ltbs_cell **map, Arena *context);
+ltbs_cell *hash_lookup_bytes(ltbs_cell **map, const byte *bytes, size_t length);
+ltbs_cell *hash_lookup_view(ltbs_cell **map, ltbs_cell *key);
+ltbs_cell *hash_lookup_hashed(ltbs_cell **map, const byte *bytes, size_t length, uint64_t hash);
+ltbs_cell *hash_adopt(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+ltbs_cell *hash_remove(ltbs_cell **map, ltbs_cell *key);
+size_t hash_count(ltbs_cell **map);
+void hash_clear(ltbs_cell **map);
+uint64_t hash_mix64(uint64_t value);
+ltbs_cell *hash_upsert_bytes(ltbs_cell **map, const void *key, size_t size, ltbs_cell *value, Arena *context);
+ltbs_cell *hash_remove_bytes(ltbs_cell **map, const void *key, size_t size);
+ltbs_cell *hash_upsert_int(ltbs_cell **map, int64_t key, ltbs_cell *value, Arena *context);
+ltbs_cell *hash_lookup_int(ltbs_cell **map, int64_t key);
+ltbs_cell *hash_remove_int(ltbs_cell **map, int64_t key);
+ltbs_cell *hash_upsert_uint(ltbs_cell **map, uint64_t key, ltbs_cell *value, Arena *context);
+ltbs_cell *hash_lookup_uint(ltbs_cell **map, uint64_t key);
+ltbs_cell *hash_remove_uint(ltbs_cell **map, uint64_t key);
+int64_t hash_key_int(ltbs_cell *key);
+uint64_t hash_key_uint(ltbs_cell *key);
+ltbs_hash_iter hash_iter(ltbs_cell **map);
+int hash_next(ltbs_hash_iter *iter, ltbs_cell **key, ltbs_cell **value);
+ltbs_cell *hash_values(ltbs_cell **map, Arena *context);
+ltbs_cell *hash_entries(ltbs_cell **map, Arena *context);
+void hash_for_each(ltbs_cell **map, entry_fn callback, void *param);
+ltbs_cell *flat_make(size_t capacity, Arena *context);
+void flat_reserve(ltbs_cell **map, size_t count, Arena *context);
+ltbs_cell *concurrent_upsert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+ltbs_cell *concurrent_insert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+ltbs_cell *concurrent_lookup(ltbs_cell **map, ltbs_cell *key);
+int concurrent_replace(ltbs_cell **map, ltbs_cell *key, ltbs_cell *expected, ltbs_cell *desired);
+ltbs_cell *persistent_upsert(ltbs_cell *map, ltbs_cell *key, ltbs_cell *value, Arena *context);
+ltbs_cell *persistent_remove(ltbs_cell *map, ltbs_cell *key, Arena *context);
 
 struct ltbs_hashmap_vt Hash_Vt = (struct ltbs_hashmap_vt)
 {
     .new = hash_make,
     .upsert = hash_upsert,
     .compute = hash_compute,
+    .compute_nocase = hash_compute_nocase,
+    .bytes = hash_bytes,
     .lookup = hash_lookup,
     .keys = hash_keys,
+    .lookup_bytes = hash_lookup_bytes,
+    .lookup_view = hash_lookup_view,
+    .lookup_hashed = hash_lookup_hashed,
+    .adopt = hash_adopt,
+    .remove = hash_remove,
+    .count = hash_count,
+    .clear = hash_clear,
+    .mix64 = hash_mix64,
+    .upsert_bytes = hash_upsert_bytes,
+    .remove_bytes = hash_remove_bytes,
+    .upsert_int = hash_upsert_int,
+    .lookup_int = hash_lookup_int,
+    .remove_int = hash_remove_int,
+    .upsert_uint = hash_upsert_uint,
+    .lookup_uint = hash_lookup_uint,
+    .remove_uint = hash_remove_uint,
+    .key_int = hash_key_int,
+    .key_uint = hash_key_uint,
+    .iter = hash_iter,
+    .next = hash_next,
+    .values = hash_values,
+    .entries = hash_entries,
+    .for_each = hash_for_each,
+};
+
+struct ltbs_flatmap_vt Flat_Vt =
+{
+    .new = flat_make,
+    .reserve = flat_reserve,
+};
+
+struct ltbs_concurrent_vt Concurrent_Vt =
+{
+    .upsert = concurrent_upsert,
+    .insert = concurrent_insert,
+    .lookup = concurrent_lookup,
+    .replace = concurrent_replace,
+};
+
+struct ltbs_persistent_vt Persistent_Vt =
+{
+    .upsert = persistent_upsert,
+    .remove = persistent_remove,
+};
+
+ltbs_intern_table *intern_new(Arena *context);
+ltbs_cell *intern_string(ltbs_intern_table *table, ltbs_cell *string);
+ltbs_cell *intern_bytes(ltbs_intern_table *table, const byte *bytes, size_t length);
+ltbs_cell *intern_cstring(ltbs_intern_table *table, const char *cstring);
+size_t intern_count(ltbs_intern_table *table);
+
+struct ltbs_intern_vt Intern_Vt = (struct ltbs_intern_vt)
+{
+    .new = intern_new,
+    .intern = intern_string,
+    .bytes = intern_bytes,
+    .cs = intern_cstring,
+    .count = intern_count,
 };
 
 ltbs_cell *format_string(char *format, ltbs_cell *data_list, Arena *context);
 ltbs_cell *format_serialize(char *format, ltbs_cell *data_map, Arena *context);
+ltbs_template *template_compile(const char *format, Arena *context);
+ltbs_cell *template_render(ltbs_template *compiled, ltbs_cell *data_map, Arena *context);
+void template_render_into(ltbs_template *compiled, ltbs_cell *data_map, ltbs_string_builder *builder);
+void template_append_value(ltbs_string_builder *builder, ltbs_cell *value);
+ltbs_template_cache *template_cache_new(Arena *context);
+ltbs_template *template_cache_get(ltbs_template_cache *cache, const char *format);
+
+struct ltbs_template_vt Template_Vt = (struct ltbs_template_vt)
+{
+    .compile = template_compile,
+    .render = template_render,
+    .render_into = template_render_into,
+    .append_value = template_append_value,
+    .cache_new = template_cache_new,
+    .cache_get = template_cache_get,
+};
+
+ltbs_cell *json_serialize(ltbs_cell *value, int options, Arena *context);
+void json_write(ltbs_string_builder *builder, ltbs_cell *value, int options);
+int json_write_fd(int fd, ltbs_cell *value, int options, Arena *context);
+ltbs_cell *json_parse(ltbs_cell *text, int options, Arena *context, ltbs_json_status *status);
+
+struct ltbs_json_vt Json_Vt = (struct ltbs_json_vt)
+{
+    .serialize = json_serialize,
+    .write = json_write,
+    .write_fd = json_write_fd,
+    .parse = json_parse,
+};
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LTBS_POSIX 1
+#define LTBS_HAS_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// x86 SIMD paths are compiled with target attributes and picked at run
+// time, so they are available without -mssse3/-mavx2.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LTBS_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
 static const ltbs_cell PAIR_NIL = (ltbs_cell)
 {
@@ -674,34 +1439,35 @@ void pair_foreach(ltbs_cell *list, callback_fn callback, void *param)
     });
 }
 
-ltbs_cell *string_from_cstring(const char *cstring, Arena *context)
+// A string cell with room for `length` bytes plus the terminator, which
+// is already written. Short strings live inside the cell.
+static ltbs_cell *string_alloc(size_t length, Arena *context)
 {
-    ltbs_cell *result = arena_alloc(context, sizeof(ltbs_cell));
-    int length = 0;
+    ltbs_cell *result = ltbs_alloc(context);
     result->type = LTBS_STRING;
-    
+    result->data.string.length = (unsigned int) length;
+
+    if ( length < LTBS_STRING_INLINE_CAPACITY )
     {
-	for ( int index = 0; cstring[index]; index++ )
-	    length++;
+	result->data.string.strdata = result->data.string.inline_data;
+	result->data.string.flags = LTBS_STRING_INLINE;
     }
 
-    byte *buffer = arena_alloc(context, length + 1);
+    else
+	result->data.string.strdata = arena_alloc(context, length + 1);
 
-    result->data.string.strdata = buffer;
-    result->data.string.length = length;
+    result->data.string.strdata[length] = 0;
 
-    {
-	for ( int index = 0; index < length + 1; index++ )
-	    buffer[index] = 0;
-    }
+    return result;
+}
 
-    {
-	for ( int index = 0; index < length; index++ )
-	    buffer[index] = cstring[index];
-    }
+ltbs_cell *string_from_cstring(const char *cstring, Arena *context)
+{
+    size_t length = strlen(cstring);
+    ltbs_cell *result = string_alloc(length, context);
+
+    memcpy(result->data.string.strdata, cstring, length);
 
-    buffer[length] = 0;
-    
     return result;
 }
 
@@ -716,7 +1482,8 @@ ltbs_cell *string_substring(ltbs_cell *string, unsigned int start, unsigned int
 
     else
     {
-	ltbs_cell *result = arena_alloc(context, sizeof(ltbs_cell));
+	ltbs_cell *result = ltbs_alloc(context);
+	result->type = LTBS_STRING;
 	result->data.string.strdata = &string->data.string.strdata[start];
 	result->data.string.length = end - start;
 
@@ -726,6 +1493,15 @@ ltbs_cell *string_substring(ltbs_cell *string, unsigned int start, unsigned int
 
 int string_compare(ltbs_cell *string1, ltbs_cell *string2)
 {
+    if ( string1 == string2 )
+	return 1;
+
+    if ( (string1 != 0) &&
+	 (string2 != 0) &&
+	 (string1->data.string.flags & string2->data.string.flags & LTBS_STRING_HASHED) &&
+	 (string1->data.string.hash != string2->data.string.hash) )
+	return 0;
+
     if ( (string1 != 0) &&
 	 (string2 != 0) &&
 	 (string1->data.string.length != string2->data.string.length) )
@@ -745,24 +1521,14 @@ int string_compare(ltbs_cell *string1, ltbs_cell *string2)
 
 ltbs_cell *string_append(ltbs_cell *string1, ltbs_cell *string2, Arena *context)
 {
-    ltbs_cell *result = arena_alloc(context, sizeof(ltbs_cell));
-    int length = string1->data.string.length + string2->data.string.length;
-    byte *bytearray = arena_alloc(context, length + 1);
-    FILE *as_file;
-    
-    result->type = LTBS_STRING;
-    result->data.string.length = length;
-    result->data.string.strdata = bytearray;
-    bytearray[length + 1] = '\0';
-
-    for ( int index = 0; index < length + 1; index++ )
-	bytearray[index] = 0;
+    size_t length1 = string1->data.string.length;
+    size_t length2 = string2->data.string.length;
+    ltbs_string_builder builder = builder_new(length1 + length2, context);
 
-    as_file = fmemopen(bytearray, length, "r+");
-    fprintf(as_file, "%s%s", string1->data.string.strdata, string2->data.string.strdata);
-    fclose(as_file);
+    builder_append_bytes(&builder, string1->data.string.strdata, length1);
+    builder_append_bytes(&builder, string2->data.string.strdata, length2);
 
-    return result;
+    return builder_finish(&builder);
 }
 
 void string_print(ltbs_cell *string)
@@ -793,16 +1559,11 @@ ltbs_cell *string_to_list(ltbs_cell *string, Arena *context)
 
 ltbs_cell *string_reverse(ltbs_cell *string, Arena *context)
 {
-    ltbs_cell *result = arena_alloc(context, sizeof(ltbs_cell));
     int length = string->data.string.length;
-    byte *buffer = arena_alloc(context, length + 1);
+    ltbs_cell *result = string_alloc(length, context);
+    byte *buffer = result->data.string.strdata;
     int inner_index = 0;
 
-    result->type = LTBS_STRING;
-    result->data.string.length = length;
-    result->data.string.strdata = buffer;
-    buffer[length + 1] = '\0';
-
     for (int index = length - 1; index > -1; index--)
     {
 	buffer[inner_index] = string->data.string.strdata[index];
@@ -814,128 +1575,288 @@ ltbs_cell *string_reverse(ltbs_cell *string, Arena *context)
 
 ltbs_cell *string_copy(ltbs_cell *string, Arena *destination)
 {
-    ltbs_cell *result = arena_alloc(destination, sizeof(ltbs_cell));
     unsigned int length = string->data.string.length;
-    byte *buffer = arena_alloc(destination, length + 1);
+    ltbs_cell *result = string_alloc(length, destination);
 
-    result->type = LTBS_STRING;
-    result->data.string.strdata = buffer;
-    result->data.string.length = length;
+    memcpy(result->data.string.strdata, string->data.string.strdata, length);
 
-    {
-	for (unsigned int index = 0; index < length + 1; index++)
-	    buffer[index] = 0;
-    }
+    return result;
+}
+
+ltbs_byteset byteset_from_string(ltbs_cell *members)
+{
+    ltbs_byteset result = {0};
 
+    for ( unsigned int index = 0; index < members->data.string.length; index++ )
     {
-	for (unsigned int index = 0; index < length; index++)
-	    buffer[index] = string->data.string.strdata[index];
+	unsigned char current = (unsigned char) members->data.string.strdata[index];
+	result.bits[current >> 6] |= (uint64_t) 1 << (current & 63);
+	result.nibbles[current >> 7][current & 15] |= (uint8_t) (1 << ((current >> 4) & 7));
     }
 
     return result;
 }
 
-ltbs_cell *string_split(ltbs_cell *string, byte splitter, Arena *context)
+int byteset_contains(ltbs_byteset *set, byte value)
 {
-    ltbs_cell *copy = string_copy(string, context);
-    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
-    byte *buffer_copy = copy->data.string.strdata;
-    
-    unsigned int index = 0;
-    unsigned int current_length = 0;
+    unsigned char current = (unsigned char) value;
+    return (int) ((set->bits[current >> 6] >> (current & 63)) & 1);
+}
 
-    while ( index < copy->data.string.length )
-    {
-	if ( buffer_copy[index] == splitter )
-	{
-	    ltbs_cell *to_add = ltbs_alloc(context);
-	    to_add->type = LTBS_STRING;
-	    to_add->data.string.strdata = &buffer_copy[index - current_length];
-	    to_add->data.string.length = current_length;
-	    buffer_copy[index] = '\0';
-	    result = pair_cons(to_add, result, context);
+static size_t byteset_scan_scalar(ltbs_byteset *set, const byte *bytes, size_t length, int members)
+{
+    for ( size_t index = 0; index < length; index++ )
+	if ( byteset_contains(set, bytes[index]) == members )
+	    return index;
 
-	    current_length = 0;
-	}
+    return length;
+}
 
-	else current_length++;
-	
-	index++;
+#ifdef LTBS_X86_SIMD
+__attribute__((target("ssse3")))
+static size_t byteset_scan_ssse3(ltbs_byteset *set, const byte *bytes, size_t length, int members)
+{
+    const __m128i low_rows = _mm_loadu_si128((const __m128i *) set->nibbles[0]);
+    const __m128i high_rows = _mm_loadu_si128((const __m128i *) set->nibbles[1]);
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i seven = _mm_set1_epi8(7);
+    unsigned int flip = members ? 0 : 0xffff;
+    size_t index = 0;
+
+    for ( ; index + 16 <= length; index += 16 )
+    {
+	__m128i input = _mm_loadu_si128((const __m128i *) &bytes[index]);
+	__m128i low = _mm_and_si128(input, nibble);
+	__m128i high = _mm_and_si128(_mm_srli_epi16(input, 4), nibble);
+	__m128i upper = _mm_cmpgt_epi8(high, seven);
+	__m128i row = _mm_or_si128(
+	    _mm_andnot_si128(upper, _mm_shuffle_epi8(low_rows, low)),
+	    _mm_and_si128(upper, _mm_shuffle_epi8(high_rows, low))
+	);
+	__m128i bit = _mm_shuffle_epi8(bits, high);
+	__m128i hits = _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
+	unsigned int mask = (unsigned int) _mm_movemask_epi8(hits) ^ flip;
+
+	if ( mask != 0 )
+	    return index + (size_t) __builtin_ctz(mask);
     }
 
-    ltbs_cell *to_add = ltbs_alloc(context);
-    to_add->type = LTBS_STRING;
-    to_add->data.string.strdata = &buffer_copy[index - current_length];
-    to_add->data.string.length = current_length;
-    buffer_copy[index] = '\0';
-    result = pair_cons(to_add, result, context);
-    result = pair_reverse(result, context);
-
-    return result;
+    return index + byteset_scan_scalar(set, &bytes[index], length - index, members);
 }
 
-int string_contains(ltbs_cell *string, byte c)
+__attribute__((target("avx2")))
+static size_t byteset_scan_avx2(ltbs_byteset *set, const byte *bytes, size_t length, int members)
 {
-    int result = 0;
-    byte *buffer = string->data.string.strdata;
-    int length = string->data.string.length;
+    const __m256i low_rows = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) set->nibbles[0]));
+    const __m256i high_rows = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) set->nibbles[1]));
+    const __m256i bits = _mm256_setr_epi8(
+	1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+	1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+    );
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i seven = _mm256_set1_epi8(7);
+    unsigned int flip = members ? 0 : 0xffffffffu;
+    size_t index = 0;
 
-    for ( int index = 0; index < length; index++ )
+    for ( ; index + 32 <= length; index += 32 )
     {
-	if ( buffer[index] == c ) result = 1;
+	__m256i input = _mm256_loadu_si256((const __m256i *) &bytes[index]);
+	__m256i low = _mm256_and_si256(input, nibble);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble);
+	__m256i upper = _mm256_cmpgt_epi8(high, seven);
+	__m256i row = _mm256_blendv_epi8(
+	    _mm256_shuffle_epi8(low_rows, low),
+	    _mm256_shuffle_epi8(high_rows, low),
+	    upper
+	);
+	__m256i bit = _mm256_shuffle_epi8(bits, high);
+	__m256i hits = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+	unsigned int mask = (unsigned int) _mm256_movemask_epi8(hits) ^ flip;
+
+	if ( mask != 0 )
+	    return index + (size_t) __builtin_ctz(mask);
     }
 
-    return result;
+    return index + byteset_scan_ssse3(set, &bytes[index], length - index, members);
 }
+#endif
 
-ltbs_cell *string_split_multi(ltbs_cell *string, ltbs_cell *splitter, Arena *context)
+// Index of the first byte that is (members = 1) or is not (members = 0)
+// in the set, or `length` when there is none.
+static size_t byteset_scan(ltbs_byteset *set, const byte *bytes, size_t length, int members)
 {
-    ltbs_cell *copy = string_copy(string, context);
-    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
-    byte *buffer_copy = copy->data.string.strdata;
-    byte *buffer = splitter->data.string.strdata;
-    int length = splitter->data.string.length;
-    
-    unsigned int index = 0;
-    unsigned int current_length = 0;
+    if ( (length == 0) || (byteset_contains(set, bytes[0]) == members) )
+	return 0;
 
-    while ( index < copy->data.string.length )
-    {
-	if ( string_contains(splitter, buffer_copy[index]) && (current_length != 0) )
-	{
-	    ltbs_cell *to_add = ltbs_alloc(context);
-	    to_add->type = LTBS_STRING;
-	    to_add->data.string.strdata = &buffer_copy[index - current_length];
-	    to_add->data.string.length = current_length;
-	    buffer_copy[index] = '\0';
-	    result = pair_cons(to_add, result, context);
+#ifdef LTBS_X86_SIMD
+    if ( (length >= 32) && __builtin_cpu_supports("avx2") )
+	return byteset_scan_avx2(set, bytes, length, members);
 
-	    current_length = 0;
-	}
+    if ( (length >= 16) && __builtin_cpu_supports("ssse3") )
+	return byteset_scan_ssse3(set, bytes, length, members);
+#endif
 
-	else if (string_contains(splitter, buffer_copy[index]))
-	    current_length = 0;
+    return byteset_scan_scalar(set, bytes, length, members);
+}
 
-	else current_length++;
-	
-	index++;
-    }
+size_t byteset_find(ltbs_byteset *set, ltbs_cell *string, size_t start)
+{
+    size_t length = string->data.string.length;
 
-    if ( string_contains(splitter, buffer_copy[index]) && (current_length != 0) )
-    {
-	ltbs_cell *to_add = ltbs_alloc(context);
-	to_add->type = LTBS_STRING;
-	to_add->data.string.strdata = &buffer_copy[index - current_length];
-	to_add->data.string.length = current_length;
-	buffer_copy[index] = '\0';
-	result = pair_cons(to_add, result, context);
-	result = pair_reverse(result, context);
-    }
+    if ( start >= length )
+	return length;
 
-    return result;
+    return start + byteset_scan(set, &string->data.string.strdata[start], length - start, 1);
 }
 
-int count_string_formats(const char *format)
+size_t byteset_skip(ltbs_byteset *set, ltbs_cell *string, size_t start)
+{
+    size_t length = string->data.string.length;
+
+    if ( start >= length )
+	return length;
+
+    return start + byteset_scan(set, &string->data.string.strdata[start], length - start, 0);
+}
+
+ltbs_split_iter string_split_iter(ltbs_cell *string, byte splitter)
+{
+    ltbs_split_iter result = {0};
+
+    result.cursor = string->data.string.strdata;
+    result.end = &string->data.string.strdata[string->data.string.length];
+    result.splitter = splitter;
+
+    return result;
+}
+
+ltbs_split_iter string_split_multi_iter(ltbs_cell *string, ltbs_cell *splitter)
+{
+    ltbs_split_iter result = string_split_iter(string, 0);
+    result.multi = 1;
+    result.splitters = byteset_from_string(splitter);
+
+    return result;
+}
+
+// Fills `token` with the next token and consumes the splitter after it.
+// Returns 0 once the string is exhausted.
+int string_split_next(ltbs_split_iter *iter, ltbs_cell *token)
+{
+    byte *start;
+    byte *stop;
+
+    if ( iter->done )
+	return 0;
+
+    if ( iter->multi )
+    {
+	size_t remaining = (size_t) (iter->end - iter->cursor);
+
+	iter->cursor += byteset_scan(&iter->splitters, iter->cursor, remaining, 0);
+
+	if ( iter->cursor == iter->end )
+	{
+	    iter->done = 1;
+	    return 0;
+	}
+
+	start = iter->cursor;
+	remaining = (size_t) (iter->end - start);
+	stop = start + byteset_scan(&iter->splitters, start, remaining, 1);
+    }
+
+    else
+    {
+	start = iter->cursor;
+	stop = memchr(start, iter->splitter, (size_t) (iter->end - start));
+
+	if ( stop == 0 )
+	    stop = iter->end;
+    }
+
+    if ( stop == iter->end )
+    {
+	iter->cursor = stop;
+	iter->done = !iter->multi;
+    }
+
+    else iter->cursor = stop + 1;
+
+    *token = (ltbs_cell) {0};
+    token->type = LTBS_STRING;
+    token->data.string.strdata = start;
+    token->data.string.length = (unsigned int) (stop - start);
+
+    return 1;
+}
+
+// Collects the remaining tokens of `iter` into an array of string cells
+// for random access. The tokens are counted first, so the array is
+// allocated once at its final size.
+ltbs_cell *string_split_collect(ltbs_split_iter iter, Arena *context)
+{
+    ltbs_split_iter counter = iter;
+    ltbs_cell token;
+    size_t length = 0;
+
+    while ( string_split_next(&counter, &token) )
+	length++;
+
+    ltbs_cell *result = ltbs_alloc(context);
+    ltbs_cell *buffer = arena_alloc(context, sizeof(ltbs_cell) * length);
+
+    result->type = LTBS_ARRAY;
+    result->data.array.elem_size = sizeof(ltbs_cell);
+    result->data.array.total_size = sizeof(ltbs_cell) * length;
+    result->data.array.buffer = buffer;
+
+    for ( size_t index = 0; string_split_next(&iter, &token); index++ )
+	buffer[index] = token;
+
+    return result;
+}
+
+// Tokens of the list forms point into one NUL-terminated copy of the
+// string, and the list is built front to back.
+static ltbs_cell *string_split_to_list(ltbs_split_iter iter, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
+    ltbs_cell **tail = &result;
+    ltbs_cell token;
+
+    while ( string_split_next(&iter, &token) )
+    {
+	ltbs_cell *to_add = ltbs_alloc(context);
+	*to_add = token;
+	token.data.string.strdata[token.data.string.length] = '\0';
+
+	*tail = pair_cons(to_add, *tail, context);
+	tail = &(*tail)->data.pair.rest;
+    }
+
+    return result;
+}
+
+ltbs_cell *string_split(ltbs_cell *string, byte splitter, Arena *context)
+{
+    ltbs_cell *copy = string_copy(string, context);
+    return string_split_to_list(string_split_iter(copy, splitter), context);
+}
+
+int string_contains(ltbs_cell *string, byte c)
+{
+    return memchr(string->data.string.strdata, c, string->data.string.length) != 0;
+}
+
+ltbs_cell *string_split_multi(ltbs_cell *string, ltbs_cell *splitter, Arena *context)
+{
+    ltbs_cell *copy = string_copy(string, context);
+    return string_split_to_list(string_split_multi_iter(copy, splitter), context);
+}
+
+int count_string_formats(const char *format)
 {
     int result = 0;
     int is_prev_percent = 0;
@@ -967,350 +1888,6068 @@ int ltbs_strlen(char *string)
     return result;
 }
 
+// Formats into a new string with the conversions listed at
+// builder_append_formatv().
 ltbs_cell *string_format(Arena *context, const char *fmt, ...)
 {
-    ltbs_cell *result = ltbs_alloc(context);
-    char *buffer;
-    size_t total_size = 0;
+    ltbs_string_builder builder = builder_new(strlen(fmt) * 2, context);
     va_list arguments;
-    FILE *as_file;
     
     va_start(arguments, fmt);
+    builder_append_formatv(&builder, fmt, arguments);
+    va_end(arguments);
+
+    return builder_finish(&builder);
+}
 
+ltbs_cell *string_from_file(const char *filepath, Arena *context)
+{
+    FILE *current_file = fopen(filepath, "rb");
+    long length = 0;
+    
+    if ( current_file == 0 )
     {
-	for (size_t index = 0; fmt[index]; index++) total_size++;
+	fprintf(stderr, "%s\n", strerror(errno));
+	return 0;
     }
 
+    fseek(current_file, 0L, SEEK_END);
+    length = ftell(current_file);
+    rewind(current_file);
+
+    if ( (length < 0) || ((unsigned long) length > UINT_MAX) )
     {
-	int total_formats = count_string_formats(fmt);
+	fprintf(stderr, "%s: %s\n", filepath, strerror(length < 0 ? errno : EFBIG));
+	fclose(current_file);
+	return 0;
+    }
 
-	for ( int index = 0; index < total_formats; index++ )
-	{
-	    char *current = va_arg(arguments, char *);
-	    total_size += ltbs_strlen(current);
-	}
+    ltbs_cell *result = ltbs_alloc(context);
+    result->type = LTBS_STRING;
+    result->data.string.strdata = arena_alloc(context, (size_t) length + 1);
+    result->data.string.length =
+	(unsigned int) fread(result->data.string.strdata, 1, (size_t) length, current_file);
+    result->data.string.strdata[result->data.string.length] = '\0';
+
+    fclose(current_file);
+    return result;
+}
 
-	buffer = arena_alloc(context, total_size + 1);
+// Maps or reads the whole of `filepath` into `handle`. Returns 0 after
+// reporting the error if the file cannot be opened or mapped, or is
+// larger than `limit` bytes, which is checked before anything is read.
+static int string_map_contents(const char *filepath, ltbs_mapped_file *handle, uint64_t limit)
+{
+    *handle = (ltbs_mapped_file) {0};
+
+#ifdef LTBS_HAS_MMAP
+    int fd = open(filepath, O_RDONLY);
+    struct stat info;
+
+    if ( fd < 0 )
+    {
+	fprintf(stderr, "%s: %s\n", filepath, strerror(errno));
+	return 0;
     }
 
+    if ( fstat(fd, &info) != 0 )
     {
-	for ( size_t index = 0; index < total_size; index++ ) buffer[index] = 0;
+	fprintf(stderr, "%s: %s\n", filepath, strerror(errno));
+	close(fd);
+	return 0;
     }
 
-    va_end(arguments);
+    if ( (uint64_t) info.st_size > limit )
+    {
+	fprintf(stderr, "%s: %s\n", filepath, strerror(EFBIG));
+	close(fd);
+	return 0;
+    }
 
-    va_start(arguments, fmt);
+    handle->length = (size_t) info.st_size;
 
-    result->type = LTBS_STRING;
-    result->data.string.length = total_size;
-    result->data.string.strdata = buffer;
+    // mmap() rejects empty mappings; an empty file is an empty view.
+    if ( handle->length > 0 )
+    {
+	void *base = mmap(0, handle->length, PROT_READ, MAP_PRIVATE, fd, 0);
 
-    as_file = fmemopen(buffer, total_size, "r+");
-    vfprintf(as_file, fmt, arguments);
-    fclose(as_file);
+	if ( base == MAP_FAILED )
+	{
+	    fprintf(stderr, "%s: %s\n", filepath, strerror(errno));
+	    close(fd);
+	    *handle = (ltbs_mapped_file) {0};
+	    return 0;
+	}
 
-    va_end(arguments);
-    return result;
-}
+	// The advice values are not flags, so each needs its own call.
+	madvise(base, handle->length, MADV_SEQUENTIAL);
+	madvise(base, handle->length, MADV_WILLNEED);
+	handle->base = base;
+	handle->is_mapped = 1;
+    }
 
-ltbs_cell *string_from_file(const char *filepath, Arena *context)
-{
-    ltbs_cell *result = arena_alloc(context, sizeof(ltbs_cell));
-    FILE *current_file = fopen(filepath, "r");
-    int length = 0;
+    // The mapping keeps its own reference to the file.
+    close(fd);
+#else
+    FILE *current_file = fopen(filepath, "rb");
+    long length = 0;
 
-    *result = (ltbs_cell) {0};
-    
     if ( current_file == 0 )
     {
-	fprintf(stderr, "%s\n", strerror(errno));
+	fprintf(stderr, "%s: %s\n", filepath, strerror(errno));
 	return 0;
     }
 
     fseek(current_file, 0L, SEEK_END);
-    length = ftell(current_file) + 1;
+    length = ftell(current_file);
     rewind(current_file);
 
-    result->data.string.length = length;
-    result->data.string.strdata = arena_alloc(context, length + 1);
-
-    for ( int index = 0; index < length + 1; index++ )
-	result->data.string.strdata[index] = 0;
-
-    fread(result->data.string.strdata, 1, length, current_file);
-
-    fclose(current_file);
-    return result;
-}
-
-int string_is_suffix(ltbs_cell *string, ltbs_cell *suffix)
-{
-    if ( suffix->data.string.length > string->data.string.length )
+    if ( (length < 0) || ((uint64_t) length > limit) )
+    {
+	fprintf(stderr, "%s: %s\n", filepath, strerror(length < 0 ? errno : EFBIG));
+	fclose(current_file);
 	return 0;
+    }
 
-    char *string_buf = string->data.string.strdata;
-    char *suffix_buf = suffix->data.string.strdata;
-    int start = string->data.string.length - suffix->data.string.length;
+    if ( length > 0 )
+    {
+	handle->base = malloc((size_t) length);
 
-    for ( unsigned int index = 0; index < suffix->data.string.length; index++ )
-	if ( suffix_buf[index] != string_buf[index + start] )
+	if ( handle->base == 0 )
+	{
+	    fprintf(stderr, "%s: %s\n", filepath, strerror(ENOMEM));
+	    fclose(current_file);
 	    return 0;
+	}
+
+	handle->length = fread(handle->base, 1, (size_t) length, current_file);
+    }
+
+    fclose(current_file);
+#endif
 
     return 1;
 }
 
-ltbs_cell *array_new(size_t elem_size, size_t total_size, Arena *context)
+// Returns a string view over the contents of `filepath` without copying
+// them into the arena; only the cell itself is allocated from `context`.
+// The view is read-only and is not NUL terminated. Since string lengths
+// are unsigned ints, files larger than UINT_MAX bytes are refused with
+// EFBIG; string_map_file_views() maps those as several views.
+ltbs_cell *string_map_file(const char *filepath, ltbs_mapped_file *handle, Arena *context)
 {
-    ltbs_cell *result = ltbs_alloc(context);
-    char *buffer = arena_alloc(context, total_size);
-    
-    result->data.array.elem_size = elem_size;
-    result->data.array.total_size = total_size;
-    result->data.array.buffer = buffer;
+    if ( !string_map_contents(filepath, handle, UINT_MAX) )
+	return 0;
 
-    for ( size_t index = 0; index < total_size; index++ ) buffer[index] = 0;
+    ltbs_cell *result = ltbs_alloc(context);
+    result->type = LTBS_STRING;
+    result->data.string.strdata = handle->base != 0 ? handle->base : (byte *) "";
+    result->data.string.length = (unsigned int) handle->length;
 
     return result;
 }
 
-ltbs_cell *array_to_list(ltbs_cell *array, Arena *context)
+// Maps `filepath` like string_map_file(), but returns a list of views
+// that cover the file in order, each at most `limit` bytes long. A
+// `limit` of 0, or one above UINT_MAX, means UINT_MAX, so files of any
+// size can be mapped. An empty file gives an empty list.
+ltbs_cell *string_map_file_views(const char *filepath, ltbs_mapped_file *handle, size_t limit, Arena *context)
 {
-    ltbs_cell *result = List_Vt.nil();
-    size_t total = array->data.array.total_size;
-    size_t elem_size = array->data.array.elem_size;
-    int length = total / elem_size;
+    if ( !string_map_contents(filepath, handle, UINT64_MAX) )
+	return 0;
 
-    for ( int index = 0; index < length; index++ )
+    if ( (limit == 0) || (limit > UINT_MAX) )
+	limit = UINT_MAX;
+
+    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
+    ltbs_cell **tail = &result;
+
+    for ( size_t offset = 0; offset < handle->length; offset += limit )
     {
-	ltbs_cell *to_add = ltbs_alloc(context);
-	to_add->type = LTBS_CUSTOM;
-	to_add->data.custom.data = &array->data.array.buffer[index * elem_size];
-	to_add->data.custom.size = elem_size;
+	size_t length = handle->length - offset < limit ? handle->length - offset : limit;
+	ltbs_cell *view = ltbs_alloc(context);
 
-	result = List_Vt.cons(to_add, result, context);
+	view->type = LTBS_STRING;
+	view->data.string.strdata = (byte *) handle->base + offset;
+	view->data.string.length = (unsigned int) length;
+
+	*tail = pair_cons(view, *tail, context);
+	tail = &(*tail)->data.pair.rest;
     }
 
     return result;
 }
 
-void *array_ref(ltbs_cell *array, unsigned int index)
+void string_unmap_file(ltbs_mapped_file *handle)
 {
-    void *result;
-    size_t offset = array->data.array.elem_size * index;
+#ifdef LTBS_HAS_MMAP
+    if ( handle->is_mapped )
+	munmap(handle->base, handle->length);
+#else
+    free(handle->base);
+#endif
 
-    if ( offset > array->data.array.total_size )
+    *handle = (ltbs_mapped_file) {0};
+}
+
+#define READER_DEFAULT_CHUNK 65536
+
+ltbs_file_reader *reader_open(const char *filepath, size_t chunk_size, Arena *context)
+{
+    FILE *current_file = fopen(filepath, "rb");
+
+    if ( current_file == 0 )
+    {
+	fprintf(stderr, "%s: %s\n", filepath, strerror(errno));
 	return 0;
+    }
+
+    // The reader's own buffer already batches the reads.
+    setvbuf(current_file, 0, _IONBF, 0);
+
+    ltbs_file_reader *result = arena_alloc(context, sizeof(ltbs_file_reader));
+    *result = (ltbs_file_reader) {0};
+
+    result->file = current_file;
+    result->context = context;
+    result->capacity = chunk_size != 0 ? chunk_size : READER_DEFAULT_CHUNK;
+    result->buffer = arena_alloc(context, result->capacity);
 
-    result = &array->data.array.buffer[offset];
-    
     return result;
 }
 
-ltbs_cell *pair_to_array(ltbs_cell *list, Arena *context)
+// Moves the unread tail to the front of the buffer, doubling the buffer
+// first if it is already full of unread bytes, then reads more after it.
+// Returns the number of bytes read, 0 at end of file.
+static size_t reader_refill(ltbs_file_reader *reader)
 {
-    ltbs_cell *result = ltbs_alloc(context);
-    int length = pair_length(list);
-    ltbs_cell *buffer = arena_alloc(context, sizeof(ltbs_cell) * length);
-    size_t elem = sizeof(ltbs_cell);
-    size_t total = elem * length;
-    ltbs_cell *tracker = list;
+    size_t pending = reader->end - reader->start;
 
-    result->type = LTBS_ARRAY;
-    result->data.array.elem_size = elem;
-    result->data.array.total_size = total;
-    result->data.array.buffer = buffer;
+    if ( reader->eof )
+	return 0;
 
-    for ( int index = 0; index < length; index++ )
+    if ( pending == reader->capacity )
     {
-	buffer[index] = *pair_head(tracker);
-	tracker = pair_rest(tracker);
+	byte *bigger = arena_alloc(reader->context, reader->capacity * 2);
+	memcpy(bigger, reader->buffer + reader->start, pending);
+	reader->buffer = bigger;
+	reader->capacity *= 2;
     }
 
-    return result;
-}
+    else if ( reader->start > 0 )
+	memmove(reader->buffer, reader->buffer + reader->start, pending);
 
-/* ltbs_cell *array_reverse(ltbs_cell *array, Arena *context) */
-/* { */
-/*     ltbs_cell *result = ltbs_alloc(context); */
-/*     int length = array->data.array.length; */
-/*     ltbs_cell **buffer = arena_alloc(context, sizeof(ltbs_cell*) * length); */
-/*     int inner_index = length; */
+    reader->start = 0;
+    reader->end = pending;
 
-/*     result->type = LTBS_ARRAY; */
-/*     result->data.array.arrdata = buffer; */
-/*     result->data.array.length = length; */
-    
-/*     for (int index = 0; index < length; index++) */
-/* 	buffer[index] = array->data.array.arrdata[inner_index--]; */
+    size_t wanted = reader->capacity - reader->end;
+    size_t read = fread(reader->buffer + reader->end, 1, wanted, reader->file);
 
-/*     return result; */
-/* } */
+    if ( read < wanted )
+	reader->eof = 1;
 
-ltbs_cell array_slice(ltbs_cell *array, int start, int end)
+    reader->end += read;
+    return read;
+}
+
+// Fills `line` with the next line, without its trailing newline. The
+// last line need not end in a newline. Returns 0 once the file is
+// exhausted.
+int reader_next_line(ltbs_file_reader *reader, ltbs_cell *line)
 {
-    size_t offset = array->data.array.elem_size * start;
-    size_t total = array->data.array.elem_size * end;
-    void *buffer = &array->data.array.buffer[offset];
-    
-    return (ltbs_cell)
+    size_t scanned = 0;
+
+    for (;;)
     {
-	.type = LTBS_ARRAY,
-	.data.array = (ltbs_array)
+	byte *pending = reader->buffer + reader->start;
+	size_t length = reader->end - reader->start;
+	byte *newline = memchr(pending + scanned, '\n', length - scanned);
+
+	if ( newline != 0 )
 	{
-	    .buffer = buffer,
-	    .elem_size = array->data.array.elem_size,
-	    .total_size = total
+	    size_t line_length = (size_t) (newline - pending);
+
+	    *line = (ltbs_cell) {0};
+	    line->type = LTBS_STRING;
+	    line->data.string.strdata = pending;
+	    line->data.string.length = (unsigned int) line_length;
+	    reader->start += line_length + 1;
+	    return 1;
 	}
-    };
-}
 
-/* ltbs_cell *array_append(ltbs_cell *array1, ltbs_cell *array2, Arena *context) */
-/* { */
-/*     ltbs_cell *result = ltbs_alloc(context); */
-/*     int length1 = array1->data.array.length; */
-/*     int length2 = array2->data.array.length; */
+	scanned = length;
+
+	if ( reader_refill(reader) == 0 )
+	    break;
+    }
+
+    if ( reader->start == reader->end )
+	return 0;
+
+    *line = (ltbs_cell) {0};
+    line->type = LTBS_STRING;
+    line->data.string.strdata = reader->buffer + reader->start;
+    line->data.string.length = (unsigned int) (reader->end - reader->start);
+    reader->start = reader->end;
+
+    return 1;
+}
+
+// Fills `chunk` with up to one buffer's worth of bytes, starting with any
+// bytes left over from next_line(). Returns 0 once the file is exhausted.
+int reader_next_chunk(ltbs_file_reader *reader, ltbs_cell *chunk)
+{
+    if ( (reader->start == reader->end) && (reader_refill(reader) == 0) )
+	return 0;
+
+    *chunk = (ltbs_cell) {0};
+    chunk->type = LTBS_STRING;
+    chunk->data.string.strdata = reader->buffer + reader->start;
+    chunk->data.string.length = (unsigned int) (reader->end - reader->start);
+    reader->start = reader->end;
+
+    return 1;
+}
+
+void reader_close(ltbs_file_reader *reader)
+{
+    if ( reader->file != 0 )
+	fclose(reader->file);
+
+    reader->file = 0;
+}
+
+int string_is_suffix(ltbs_cell *string, ltbs_cell *suffix)
+{
+    if ( suffix->data.string.length > string->data.string.length )
+	return 0;
+
+    char *string_buf = string->data.string.strdata;
+    char *suffix_buf = suffix->data.string.strdata;
+    int start = string->data.string.length - suffix->data.string.length;
+
+    for ( unsigned int index = 0; index < suffix->data.string.length; index++ )
+	if ( suffix_buf[index] != string_buf[index + start] )
+	    return 0;
+
+    return 1;
+}
+
+#define BUILDER_MIN_CAPACITY 64
+
+// Number of arena words backing a builder buffer of `size` bytes
+static size_t builder_words(size_t size)
+{
+    return (size + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+}
+
+// Nonzero when the buffer is the most recent allocation of its arena,
+// i.e. it can still grow or shrink by moving the region's count.
+static int builder_at_arena_top(ltbs_string_builder *builder)
+{
+    Region *end = builder->context->end;
+
+    return (builder->buffer != 0) &&
+	(end != 0) &&
+	((uintptr_t *) builder->buffer + builder_words(builder->capacity) == &end->data[end->count]);
+}
+
+ltbs_string_builder builder_new(size_t capacity, Arena *context)
+{
+    ltbs_string_builder result = (ltbs_string_builder)
+    {
+	.context = context,
+	.buffer = 0,
+	.length = 0,
+	.capacity = 0
+    };
+
+    if ( capacity > 0 )
+	builder_reserve(&result, capacity);
+
+    return result;
+}
+
+// Makes room for `additional` more bytes plus the terminating NUL
+// written by builder_finish().
+void builder_reserve(ltbs_string_builder *builder, size_t additional)
+{
+    size_t needed = builder->length + additional + 1;
+    size_t new_capacity;
+
+    if ( needed <= builder->capacity )
+	return;
+
+    if ( builder->capacity == 0 )
+	new_capacity = needed < BUILDER_MIN_CAPACITY ? BUILDER_MIN_CAPACITY : needed;
+
+    else
+    {
+	new_capacity = builder->capacity * 2;
+	while ( new_capacity < needed ) new_capacity *= 2;
+    }
+
+    new_capacity = builder_words(new_capacity) * sizeof(uintptr_t);
+
+    if ( builder_at_arena_top(builder) )
+    {
+	Region *end = builder->context->end;
+	size_t extra = builder_words(new_capacity) - builder_words(builder->capacity);
+
+	if ( end->count + extra <= end->capacity )
+	{
+	    end->count += extra;
+	    builder->capacity = new_capacity;
+	    return;
+	}
+    }
+
+    byte *buffer = arena_alloc(builder->context, new_capacity);
+
+    if ( builder->length > 0 )
+	memcpy(buffer, builder->buffer, builder->length);
+
+    builder->buffer = buffer;
+    builder->capacity = new_capacity;
+}
+
+void builder_append_bytes(ltbs_string_builder *builder, const byte *bytes, size_t length)
+{
+    if ( length == 0 )
+	return;
+
+    builder_reserve(builder, length);
+    memcpy(&builder->buffer[builder->length], bytes, length);
+    builder->length += length;
+}
+
+void builder_append_byte(ltbs_string_builder *builder, byte value)
+{
+    builder_reserve(builder, 1);
+    builder->buffer[builder->length++] = value;
+}
+
+void builder_append_cstring(ltbs_string_builder *builder, const char *cstring)
+{
+    builder_append_bytes(builder, cstring, strlen(cstring));
+}
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes the decimal digits of `value` so that they end right before
+// `end`, returning a pointer to the first digit.
+static byte *ltbs_write_uint(byte *end, uint64_t value)
+{
+    byte *cursor = end;
+
+    while ( value >= 100 )
+    {
+	unsigned int pair = (unsigned int) (value % 100) * 2;
+	value /= 100;
+	*--cursor = DIGIT_PAIRS[pair + 1];
+	*--cursor = DIGIT_PAIRS[pair];
+    }
+
+    if ( value >= 10 )
+    {
+	unsigned int pair = (unsigned int) value * 2;
+	*--cursor = DIGIT_PAIRS[pair + 1];
+	*--cursor = DIGIT_PAIRS[pair];
+    }
+
+    else *--cursor = (byte) ('0' + value);
+
+    return cursor;
+}
+
+void builder_append_uint(ltbs_string_builder *builder, uint64_t value)
+{
+    byte digits[20];
+    byte *end = digits + sizeof(digits);
+    byte *start = ltbs_write_uint(end, value);
+
+    builder_append_bytes(builder, start, (size_t) (end - start));
+}
+
+void builder_append_int(ltbs_string_builder *builder, int64_t value)
+{
+    byte digits[21];
+    byte *end = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    byte *start = ltbs_write_uint(end, magnitude);
+
+    if ( value < 0 )
+	*--start = '-';
+
+    builder_append_bytes(builder, start, (size_t) (end - start));
+}
+
+// Shortest round-trip float printing, after Florian Loitsch's Grisu2
+// ("Printing Floating-Point Numbers Quickly and Accurately with
+// Integers", 2010). Values are handled as 64-bit significand/exponent
+// pairs so that floats and doubles share the digit generation.
+typedef struct ltbs_diyfp
+{
+    uint64_t f;
+    int e;
+} ltbs_diyfp;
+
+// Normalized 64-bit approximations of 10^k for k = -348, -340, ..., 340.
+static const struct { uint64_t f; int e; } GRISU_CACHED_POWERS[87] =
+{
+    { 0xfa8fd5a0081c0288ULL, -1220 }, { 0xbaaee17fa23ebf76ULL, -1193 }, { 0x8b16fb203055ac76ULL, -1166 },
+    { 0xcf42894a5dce35eaULL, -1140 }, { 0x9a6bb0aa55653b2dULL, -1113 }, { 0xe61acf033d1a45dfULL, -1087 },
+    { 0xab70fe17c79ac6caULL, -1060 }, { 0xff77b1fcbebcdc4fULL, -1034 }, { 0xbe5691ef416bd60cULL, -1007 },
+    { 0x8dd01fad907ffc3cULL, -980 }, { 0xd3515c2831559a83ULL, -954 }, { 0x9d71ac8fada6c9b5ULL, -927 },
+    { 0xea9c227723ee8bcbULL, -901 }, { 0xaecc49914078536dULL, -874 }, { 0x823c12795db6ce57ULL, -847 },
+    { 0xc21094364dfb5637ULL, -821 }, { 0x9096ea6f3848984fULL, -794 }, { 0xd77485cb25823ac7ULL, -768 },
+    { 0xa086cfcd97bf97f4ULL, -741 }, { 0xef340a98172aace5ULL, -715 }, { 0xb23867fb2a35b28eULL, -688 },
+    { 0x84c8d4dfd2c63f3bULL, -661 }, { 0xc5dd44271ad3cdbaULL, -635 }, { 0x936b9fcebb25c996ULL, -608 },
+    { 0xdbac6c247d62a584ULL, -582 }, { 0xa3ab66580d5fdaf6ULL, -555 }, { 0xf3e2f893dec3f126ULL, -529 },
+    { 0xb5b5ada8aaff80b8ULL, -502 }, { 0x87625f056c7c4a8bULL, -475 }, { 0xc9bcff6034c13053ULL, -449 },
+    { 0x964e858c91ba2655ULL, -422 }, { 0xdff9772470297ebdULL, -396 }, { 0xa6dfbd9fb8e5b88fULL, -369 },
+    { 0xf8a95fcf88747d94ULL, -343 }, { 0xb94470938fa89bcfULL, -316 }, { 0x8a08f0f8bf0f156bULL, -289 },
+    { 0xcdb02555653131b6ULL, -263 }, { 0x993fe2c6d07b7facULL, -236 }, { 0xe45c10c42a2b3b06ULL, -210 },
+    { 0xaa242499697392d3ULL, -183 }, { 0xfd87b5f28300ca0eULL, -157 }, { 0xbce5086492111aebULL, -130 },
+    { 0x8cbccc096f5088ccULL, -103 }, { 0xd1b71758e219652cULL, -77 }, { 0x9c40000000000000ULL, -50 },
+    { 0xe8d4a51000000000ULL, -24 }, { 0xad78ebc5ac620000ULL, 3 }, { 0x813f3978f8940984ULL, 30 },
+    { 0xc097ce7bc90715b3ULL, 56 }, { 0x8f7e32ce7bea5c70ULL, 83 }, { 0xd5d238a4abe98068ULL, 109 },
+    { 0x9f4f2726179a2245ULL, 136 }, { 0xed63a231d4c4fb27ULL, 162 }, { 0xb0de65388cc8ada8ULL, 189 },
+    { 0x83c7088e1aab65dbULL, 216 }, { 0xc45d1df942711d9aULL, 242 }, { 0x924d692ca61be758ULL, 269 },
+    { 0xda01ee641a708deaULL, 295 }, { 0xa26da3999aef774aULL, 322 }, { 0xf209787bb47d6b85ULL, 348 },
+    { 0xb454e4a179dd1877ULL, 375 }, { 0x865b86925b9bc5c2ULL, 402 }, { 0xc83553c5c8965d3dULL, 428 },
+    { 0x952ab45cfa97a0b3ULL, 455 }, { 0xde469fbd99a05fe3ULL, 481 }, { 0xa59bc234db398c25ULL, 508 },
+    { 0xf6c69a72a3989f5cULL, 534 }, { 0xb7dcbf5354e9beceULL, 561 }, { 0x88fcf317f22241e2ULL, 588 },
+    { 0xcc20ce9bd35c78a5ULL, 614 }, { 0x98165af37b2153dfULL, 641 }, { 0xe2a0b5dc971f303aULL, 667 },
+    { 0xa8d9d1535ce3b396ULL, 694 }, { 0xfb9b7cd9a4a7443cULL, 720 }, { 0xbb764c4ca7a44410ULL, 747 },
+    { 0x8bab8eefb6409c1aULL, 774 }, { 0xd01fef10a657842cULL, 800 }, { 0x9b10a4e5e9913129ULL, 827 },
+    { 0xe7109bfba19c0c9dULL, 853 }, { 0xac2820d9623bf429ULL, 880 }, { 0x80444b5e7aa7cf85ULL, 907 },
+    { 0xbf21e44003acdd2dULL, 933 }, { 0x8e679c2f5e44ff8fULL, 960 }, { 0xd433179d9c8cb841ULL, 986 },
+    { 0x9e19db92b4e31ba9ULL, 1013 }, { 0xeb96bf6ebadf77d9ULL, 1039 }, { 0xaf87023b9bf0ee6bULL, 1066 },
+};
+
+static const uint64_t GRISU_POW10[20] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static ltbs_diyfp diyfp_normalize(ltbs_diyfp value)
+{
+    int shift = __builtin_clzll(value.f);
+    return (ltbs_diyfp) { value.f << shift, value.e - shift };
+}
+
+// Upper 64 bits of the 128-bit product, rounded.
+static ltbs_diyfp diyfp_multiply(ltbs_diyfp lhs, ltbs_diyfp rhs)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = (__uint128_t) lhs.f * rhs.f;
+    uint64_t high = (uint64_t) (product >> 64);
+    uint64_t low = (uint64_t) product;
+
+    return (ltbs_diyfp) { high + (low >> 63), lhs.e + rhs.e + 64 };
+#else
+    const uint64_t mask = 0xFFFFFFFFu;
+    uint64_t a = lhs.f >> 32, b = lhs.f & mask;
+    uint64_t c = rhs.f >> 32, d = rhs.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1u << 31);
+
+    return (ltbs_diyfp) { ac + (ad >> 32) + (bc >> 32) + (middle >> 32), lhs.e + rhs.e + 64 };
+#endif
+}
+
+static void grisu_round(byte *digits, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t distance)
+{
+    while ( (rest < distance) &&
+	    (delta - rest >= ten_kappa) &&
+	    ((rest + ten_kappa < distance) ||
+	     (distance - rest > rest + ten_kappa - distance)) )
+    {
+	digits[length - 1]--;
+	rest += ten_kappa;
+    }
+}
+
+static int grisu_digit_count(uint32_t value)
+{
+    int result = 1;
+
+    while ( (result < 10) && (value >= GRISU_POW10[result]) )
+	result++;
+
+    return result;
+}
+
+static int grisu_generate(ltbs_diyfp w, ltbs_diyfp upper, uint64_t delta, byte *digits, int *decimal_exponent)
+{
+    ltbs_diyfp one = { (uint64_t) 1 << -upper.e, upper.e };
+    uint64_t distance = upper.f - w.f;
+    uint32_t integral = (uint32_t) (upper.f >> -one.e);
+    uint64_t fraction = upper.f & (one.f - 1);
+    int kappa = grisu_digit_count(integral);
+    int length = 0;
+
+    while ( kappa > 0 )
+    {
+	uint32_t digit = (uint32_t) (integral / GRISU_POW10[kappa - 1]);
+	integral = (uint32_t) (integral % GRISU_POW10[kappa - 1]);
+
+	if ( digit || length )
+	    digits[length++] = (byte) ('0' + digit);
+
+	kappa--;
+
+	uint64_t rest = ((uint64_t) integral << -one.e) + fraction;
+
+	if ( rest <= delta )
+	{
+	    *decimal_exponent += kappa;
+	    grisu_round(digits, length, delta, rest, GRISU_POW10[kappa] << -one.e, distance);
+	    return length;
+	}
+    }
+
+    for (;;)
+    {
+	fraction *= 10;
+	delta *= 10;
+
+	byte digit = (byte) (fraction >> -one.e);
+
+	if ( digit || length )
+	    digits[length++] = (byte) ('0' + digit);
+
+	fraction &= one.f - 1;
+	kappa--;
+
+	if ( fraction < delta )
+	{
+	    *decimal_exponent += kappa;
+	    grisu_round(digits, length, delta, fraction, one.f,
+			distance * (-kappa < 20 ? GRISU_POW10[-kappa] : 0));
+	    return length;
+	}
+    }
+}
+
+// Writes the shortest digits of significand * 2^exponent that read back
+// as the same value, and stores the power of ten they are scaled by.
+// `lower_closer` is set when the next smaller value is only half an ulp
+// away, which happens at powers of two.
+static int grisu2(uint64_t significand, int exponent, int lower_closer, byte *digits, int *decimal_exponent)
+{
+    ltbs_diyfp value = { significand, exponent };
+    ltbs_diyfp upper = diyfp_normalize((ltbs_diyfp) { (significand << 1) + 1, exponent - 1 });
+    ltbs_diyfp lower = lower_closer
+	? (ltbs_diyfp) { (significand << 2) - 1, exponent - 2 }
+	: (ltbs_diyfp) { (significand << 1) - 1, exponent - 1 };
+
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+
+    // Pick the cached power that brings the scaled exponent into [-60, -32].
+    double estimate = (-61 - upper.e) * 0.30102999566398114 + 347;
+    int k = (int) estimate;
+
+    if ( k != estimate )
+	k++;
+
+    int index = (k >> 3) + 1;
+    ltbs_diyfp cached = { GRISU_CACHED_POWERS[index].f, GRISU_CACHED_POWERS[index].e };
+    ltbs_diyfp w = diyfp_multiply(diyfp_normalize(value), cached);
+    ltbs_diyfp scaled_upper = diyfp_multiply(upper, cached);
+    ltbs_diyfp scaled_lower = diyfp_multiply(lower, cached);
+
+    scaled_lower.f++;
+    scaled_upper.f--;
+    *decimal_exponent = 348 - index * 8;
+
+    return grisu_generate(w, scaled_upper, scaled_upper.f - scaled_lower.f, digits, decimal_exponent);
+}
+
+// Lays out digits * 10^decimal_exponent the way JavaScript prints
+// numbers: plain decimals between 1e-6 and 1e21, exponent form outside.
+static int grisu_layout(byte *out, byte *digits, int length, int decimal_exponent)
+{
+    int point = length + decimal_exponent;
+    int written = 0;
+
+    if ( (length <= point) && (point <= 21) )
+    {
+	memcpy(out, digits, (size_t) length);
+	memset(out + length, '0', (size_t) (point - length));
+	return point;
+    }
+
+    if ( (0 < point) && (point <= 21) )
+    {
+	memcpy(out, digits, (size_t) point);
+	out[point] = '.';
+	memcpy(out + point + 1, digits + point, (size_t) (length - point));
+	return length + 1;
+    }
+
+    if ( (-6 < point) && (point <= 0) )
+    {
+	out[0] = '0';
+	out[1] = '.';
+	memset(out + 2, '0', (size_t) -point);
+	memcpy(out + 2 - point, digits, (size_t) length);
+	return 2 - point + length;
+    }
+
+    out[written++] = digits[0];
+
+    if ( length > 1 )
+    {
+	out[written++] = '.';
+	memcpy(out + written, digits + 1, (size_t) (length - 1));
+	written += length - 1;
+    }
+
+    int exponent = point - 1;
+    byte exponent_digits[4];
+    byte *end = exponent_digits + sizeof(exponent_digits);
+    byte *start = ltbs_write_uint(end, (uint64_t) (exponent < 0 ? -exponent : exponent));
+
+    out[written++] = 'e';
+    out[written++] = exponent < 0 ? '-' : '+';
+    memcpy(out + written, start, (size_t) (end - start));
+
+    return written + (int) (end - start);
+}
+
+// Formats a binary floating point value given as its raw fields. `out`
+// needs room for 32 bytes.
+static int ltbs_write_binary_float(byte *out, int negative, uint64_t fraction, int biased_exponent,
+				   int fraction_bits, int exponent_bias, int max_exponent)
+{
+    byte digits[24];
+    int written = 0;
+    int decimal_exponent = 0;
+    uint64_t hidden = (uint64_t) 1 << fraction_bits;
+
+    if ( biased_exponent == max_exponent )
+    {
+	if ( fraction != 0 )
+	{
+	    memcpy(out, "nan", 3);
+	    return 3;
+	}
+
+	if ( negative )
+	    out[written++] = '-';
+
+	memcpy(out + written, "inf", 3);
+	return written + 3;
+    }
+
+    if ( negative )
+	out[written++] = '-';
+
+    if ( (biased_exponent == 0) && (fraction == 0) )
+    {
+	out[written++] = '0';
+	return written;
+    }
+
+    uint64_t significand = biased_exponent != 0 ? fraction | hidden : fraction;
+    int exponent = (biased_exponent != 0 ? biased_exponent : 1) - exponent_bias - fraction_bits;
+    int lower_closer = (fraction == 0) && (biased_exponent > 1);
+    int length = grisu2(significand, exponent, lower_closer, digits, &decimal_exponent);
+
+    return written + grisu_layout(out + written, digits, length, decimal_exponent);
+}
+
+static int ltbs_write_double(byte *out, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    return ltbs_write_binary_float(out, (int) (bits >> 63), bits & (((uint64_t) 1 << 52) - 1),
+				   (int) ((bits >> 52) & 0x7FF), 52, 1023, 0x7FF);
+}
+
+static int ltbs_write_float(byte *out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    return ltbs_write_binary_float(out, (int) (bits >> 31), bits & ((1u << 23) - 1),
+				   (int) ((bits >> 23) & 0xFF), 23, 127, 0xFF);
+}
+
+void builder_append_float(ltbs_string_builder *builder, double value)
+{
+    byte digits[32];
+    int length = ltbs_write_double(digits, value);
+
+    builder_append_bytes(builder, digits, (size_t) length);
+}
+
+// Strings and scalars are written as text; compound cells are left to
+// format_string().
+void builder_append_cell(ltbs_string_builder *builder, ltbs_cell *cell)
+{
+    switch ( cell->type )
+    {
+	case LTBS_STRING:
+	    builder_append_bytes(builder, cell->data.string.strdata, cell->data.string.length);
+	    break;
+
+	case LTBS_BYTE: builder_append_byte(builder, cell->data.byteval); break;
+	case LTBS_INT: builder_append_int(builder, cell->data.integer); break;
+	case LTBS_UINT: builder_append_uint(builder, cell->data.uinteger); break;
+	case LTBS_FLOAT:
+	{
+	    byte digits[32];
+	    int length = ltbs_write_float(digits, cell->data.floatval);
+	    builder_append_bytes(builder, digits, (size_t) length);
+	}
+	break;
+
+	case LTBS_ROPE:
+	{
+	    ltbs_rope_iter iter = rope_iter(cell);
+	    ltbs_cell chunk;
+
+	    builder_reserve(builder, rope_length(cell));
+
+	    while ( rope_next(&iter, &chunk) )
+		builder_append_bytes(builder, chunk.data.string.strdata, chunk.data.string.length);
+	}
+	break;
+
+	default: break;
+    }
+}
+
+// Formats a single printf conversion `spec` and its argument with
+// vsnprintf(), straight into the builder.
+static void builder_append_spec(ltbs_string_builder *builder, const char *spec, ...)
+{
+    va_list arguments;
+    va_list measure;
+
+    va_start(arguments, spec);
+    va_copy(measure, arguments);
+    int length = vsnprintf(0, 0, spec, measure);
+    va_end(measure);
+
+    if ( length > 0 )
+    {
+	builder_reserve(builder, (size_t) length);
+	vsnprintf(builder->buffer + builder->length, (size_t) length + 1, spec, arguments);
+	builder->length += (size_t) length;
+    }
+
+    va_end(arguments);
+}
+
+static void format_unsupported(const char *fmt)
+{
+    fprintf(stderr, "builder_append_formatv: unsupported conversion in \"%s\"\n", fmt);
+    abort();
+}
+
+// Adds `length` bytes to the conversion being rebuilt for snprintf().
+static void format_spec_add(char *spec, size_t *spec_length, const char *fmt, const char *text, size_t length)
+{
+    if ( *spec_length + length >= 64 )
+	format_unsupported(fmt);
+
+    memcpy(spec + *spec_length, text, length);
+    *spec_length += length;
+}
+
+// printf-style formatting straight into the builder, in one pass over
+// `fmt`. Conversions:
+//   %d %i    signed integer    (with hh, h, l, ll, z, j or t)
+//   %u       unsigned integer  (same modifiers)
+//   %x %X    unsigned hexadecimal
+//   %f %g    double, shortest form that reads back as the same value,
+//            not printf's six decimals; give a precision for those
+//   %s       NUL-terminated char *, "(null)" for 0
+//   %S       ltbs_cell *, written as by builder_append_cell()
+//   %c       single byte
+//   %%       literal percent sign
+// Flags, widths and precisions (`*` taking an int), %o, %p, %e, %E,
+// %F, %G, %a, %A and the L modifier follow printf, through snprintf().
+// Anything else, such as %n or wide characters, aborts rather than
+// fall out of step with the arguments.
+void builder_append_formatv(ltbs_string_builder *builder, const char *fmt, va_list arguments)
+{
+    const char *cursor = fmt;
+
+    for (;;)
+    {
+	const char *percent = strchr(cursor, '%');
+
+	if ( percent == 0 )
+	{
+	    builder_append_bytes(builder, cursor, strlen(cursor));
+	    return;
+	}
+
+	builder_append_bytes(builder, cursor, (size_t) (percent - cursor));
+	cursor = percent + 1;
+
+	// The conversion is rebuilt in `spec`, with any `*` replaced by
+	// its value, in case it has to go to snprintf().
+	char spec[64] = "%";
+	size_t spec_length = 1;
+	int plain = 1;
+
+	while ( (*cursor != '\0') && (strchr("-+ #0", *cursor) != 0) )
+	{
+	    format_spec_add(spec, &spec_length, fmt, cursor++, 1);
+	    plain = 0;
+	}
+
+	for ( int part = 0; part < 2; part++ )
+	{
+	    if ( part == 1 )
+	    {
+		if ( *cursor != '.' )
+		    break;
+
+		cursor++;
+		plain = 0;
+	    }
+
+	    if ( *cursor == '*' )
+	    {
+		int value = va_arg(arguments, int);
+		char digits[16];
+		cursor++;
+		plain = 0;
+
+		// A negative precision counts as none at all.
+		if ( (part == 1) && (value < 0) )
+		    continue;
+
+		if ( part == 1 )
+		    format_spec_add(spec, &spec_length, fmt, ".", 1);
+
+		format_spec_add(spec, &spec_length, fmt, digits, (size_t) snprintf(digits, sizeof(digits), "%d", value));
+		continue;
+	    }
+
+	    if ( part == 1 )
+		format_spec_add(spec, &spec_length, fmt, ".", 1);
+
+	    while ( (*cursor >= '0') && (*cursor <= '9') )
+	    {
+		format_spec_add(spec, &spec_length, fmt, cursor++, 1);
+		plain = 0;
+	    }
+	}
+
+	// 0: int, 1: long, 2: long long, 3: size_t, 4: intmax_t,
+	// 5: ptrdiff_t, 6: long double, 7: short, 8: char
+	int width = 0;
+	const char *modifier = cursor;
+	size_t modifier_at = spec_length;
+
+	if ( *cursor == 'l' )
+	{
+	    width = 1;
+	    cursor++;
+
+	    if ( *cursor == 'l' )
+	    {
+		width = 2;
+		cursor++;
+	    }
+	}
+
+	else if ( *cursor == 'z' ) { width = 3; cursor++; }
+	else if ( *cursor == 'j' ) { width = 4; cursor++; }
+	else if ( *cursor == 't' ) { width = 5; cursor++; }
+	else if ( *cursor == 'L' ) { width = 6; cursor++; }
+	else if ( *cursor == 'h' )
+	{
+	    width = 7;
+	    cursor++;
+
+	    if ( *cursor == 'h' )
+	    {
+		width = 8;
+		cursor++;
+	    }
+	}
+
+	format_spec_add(spec, &spec_length, fmt, modifier, (size_t) (cursor + 1 - modifier));
+	spec[spec_length] = '\0';
+
+	switch ( *cursor )
+	{
+	    case 'd':
+	    case 'i':
+	    {
+		int64_t value;
+
+		switch ( width )
+		{
+		    case 1: value = va_arg(arguments, long); break;
+		    case 2: value = va_arg(arguments, long long); break;
+		    case 3: value = (int64_t) va_arg(arguments, size_t); break;
+		    case 4: value = va_arg(arguments, intmax_t); break;
+		    case 5: value = va_arg(arguments, ptrdiff_t); break;
+		    case 6: format_unsupported(fmt); return;
+		    case 7: value = (short) va_arg(arguments, int); break;
+		    case 8: value = (signed char) va_arg(arguments, int); break;
+		    default: value = va_arg(arguments, int); break;
+		}
+
+		if ( plain )
+		{
+		    builder_append_int(builder, value);
+		    break;
+		}
+
+		// snprintf() is handed the widest type, so the conversion
+		// is redone with ll whatever modifier `fmt` had.
+		spec_length = modifier_at;
+		format_spec_add(spec, &spec_length, fmt, "ll", 2);
+		format_spec_add(spec, &spec_length, fmt, cursor, 1);
+		spec[spec_length] = '\0';
+		builder_append_spec(builder, spec, (long long) value);
+	    }
+	    break;
+
+	    case 'u':
+	    case 'x':
+	    case 'X':
+	    case 'o':
+	    {
+		uint64_t value;
+
+		switch ( width )
+		{
+		    case 1: value = va_arg(arguments, unsigned long); break;
+		    case 2: value = va_arg(arguments, unsigned long long); break;
+		    case 3: value = va_arg(arguments, size_t); break;
+		    case 4: value = va_arg(arguments, uintmax_t); break;
+		    case 5: value = (uint64_t) va_arg(arguments, ptrdiff_t); break;
+		    case 6: format_unsupported(fmt); return;
+		    case 7: value = (unsigned short) va_arg(arguments, unsigned int); break;
+		    case 8: value = (unsigned char) va_arg(arguments, unsigned int); break;
+		    default: value = va_arg(arguments, unsigned int); break;
+		}
+
+		if ( !plain || (*cursor == 'o') )
+		{
+		    spec_length = modifier_at;
+		    format_spec_add(spec, &spec_length, fmt, "ll", 2);
+		    format_spec_add(spec, &spec_length, fmt, cursor, 1);
+		    spec[spec_length] = '\0';
+		    builder_append_spec(builder, spec, (unsigned long long) value);
+		    break;
+		}
+
+		if ( *cursor == 'u' )
+		{
+		    builder_append_uint(builder, value);
+		    break;
+		}
+
+		const char *hex = *cursor == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+		byte digits[16];
+		byte *start = digits + sizeof(digits);
+
+		do
+		{
+		    *--start = (byte) hex[value & 0xF];
+		    value >>= 4;
+		} while ( value != 0 );
+
+		builder_append_bytes(builder, start, (size_t) (digits + sizeof(digits) - start));
+	    }
+	    break;
+
+	    case 'f':
+	    case 'g':
+	    case 'F':
+	    case 'e':
+	    case 'E':
+	    case 'G':
+	    case 'a':
+	    case 'A':
+		if ( (width > 1) && (width != 6) )
+		    format_unsupported(fmt);
+
+		if ( width == 6 )
+		    builder_append_spec(builder, spec, va_arg(arguments, long double));
+
+		else if ( plain && ((*cursor == 'f') || (*cursor == 'g')) )
+		    builder_append_float(builder, va_arg(arguments, double));
+
+		else builder_append_spec(builder, spec, va_arg(arguments, double));
+		break;
+
+	    case 's':
+	    {
+		const char *cstring = va_arg(arguments, const char *);
+
+		if ( width != 0 )
+		    format_unsupported(fmt);
+
+		if ( cstring == 0 )
+		    cstring = "(null)";
+
+		if ( plain )
+		    builder_append_cstring(builder, cstring);
+
+		else builder_append_spec(builder, spec, cstring);
+	    }
+	    break;
+
+	    case 'S':
+	    {
+		if ( !plain || (width != 0) )
+		    format_unsupported(fmt);
+
+		ltbs_cell *cell = va_arg(arguments, ltbs_cell *);
+
+		if ( cell != 0 )
+		    builder_append_cell(builder, cell);
+	    }
+	    break;
+
+	    case 'c':
+	    {
+		int value = va_arg(arguments, int);
+
+		if ( width != 0 )
+		    format_unsupported(fmt);
+
+		if ( plain )
+		    builder_append_byte(builder, (byte) value);
+
+		else builder_append_spec(builder, spec, value);
+	    }
+	    break;
+
+	    case 'p':
+		if ( width != 0 )
+		    format_unsupported(fmt);
+
+		builder_append_spec(builder, spec, va_arg(arguments, void *));
+		break;
+
+	    case '%':
+		if ( !plain || (width != 0) )
+		    format_unsupported(fmt);
+
+		builder_append_byte(builder, '%');
+		break;
+
+	    case '\0':
+		if ( !plain || (width != 0) )
+		    format_unsupported(fmt);
+
+		builder_append_byte(builder, '%');
+		return;
+
+	    default:
+		format_unsupported(fmt);
+		return;
+	}
+
+	cursor++;
+    }
+}
+
+void builder_append_format(ltbs_string_builder *builder, const char *fmt, ...)
+{
+    va_list arguments;
+
+    va_start(arguments, fmt);
+    builder_append_formatv(builder, fmt, arguments);
+    va_end(arguments);
+}
+
+// NUL-terminates the buffer, returns the unused tail to the arena when
+// possible and wraps the bytes in a string cell. The builder is left
+// empty and can be reused.
+ltbs_cell *builder_finish(ltbs_string_builder *builder)
+{
+    builder_reserve(builder, 0);
+    builder->buffer[builder->length] = '\0';
+
+    if ( builder_at_arena_top(builder) )
+    {
+	size_t used = builder_words(builder->length + 1);
+	builder->context->end->count -= builder_words(builder->capacity) - used;
+    }
+
+    ltbs_cell *result = ltbs_alloc(builder->context);
+    result->type = LTBS_STRING;
+    result->data.string.strdata = builder->buffer;
+    result->data.string.length = (unsigned int) builder->length;
+
+    builder->buffer = 0;
+    builder->length = 0;
+    builder->capacity = 0;
+
+    return result;
+}
+
+// Leaves shorter than this are merged by copying when concatenated,
+// so that building a rope one small piece at a time stays shallow.
+#define ROPE_LEAF_MERGE 128
+
+static unsigned int rope_height(ltbs_cell *rope)
+{
+    return rope ? rope->data.rope.height : 0;
+}
+
+static int rope_is_leaf(ltbs_cell *rope)
+{
+    return rope->data.rope.left == 0;
+}
+
+static ltbs_cell *rope_leaf(byte *strdata, size_t length, Arena *context)
+{
+    if ( length == 0 )
+	return 0;
+
+    ltbs_cell *result = ltbs_alloc(context);
+    result->type = LTBS_ROPE;
+    result->data.rope.strdata = strdata;
+    result->data.rope.length = length;
+    result->data.rope.height = 1;
+
+    return result;
+}
+
+static ltbs_cell *rope_node(ltbs_cell *left, ltbs_cell *right, Arena *context)
+{
+    if ( left == 0 ) return right;
+    if ( right == 0 ) return left;
+
+    unsigned int left_height = left->data.rope.height;
+    unsigned int right_height = right->data.rope.height;
+    ltbs_cell *result = ltbs_alloc(context);
+
+    result->type = LTBS_ROPE;
+    result->data.rope.left = left;
+    result->data.rope.right = right;
+    result->data.rope.length = left->data.rope.length + right->data.rope.length;
+    result->data.rope.height = 1 + (left_height > right_height ? left_height : right_height);
+
+    return result;
+}
+
+// Builds a node from two subtrees whose heights differ by at most two,
+// rotating once or twice to restore the AVL invariant.
+static ltbs_cell *rope_balance(ltbs_cell *left, ltbs_cell *right, Arena *context)
+{
+    unsigned int left_height = rope_height(left);
+    unsigned int right_height = rope_height(right);
+
+    if ( left_height > right_height + 1 )
+    {
+	ltbs_cell *outer = left->data.rope.left;
+	ltbs_cell *inner = left->data.rope.right;
+
+	if ( rope_height(outer) >= rope_height(inner) )
+	    return rope_node(outer, rope_node(inner, right, context), context);
+
+	return rope_node(
+	    rope_node(outer, inner->data.rope.left, context),
+	    rope_node(inner->data.rope.right, right, context),
+	    context
+	);
+    }
+
+    if ( right_height > left_height + 1 )
+    {
+	ltbs_cell *outer = right->data.rope.right;
+	ltbs_cell *inner = right->data.rope.left;
+
+	if ( rope_height(outer) >= rope_height(inner) )
+	    return rope_node(rope_node(left, inner, context), outer, context);
+
+	return rope_node(
+	    rope_node(left, inner->data.rope.left, context),
+	    rope_node(inner->data.rope.right, outer, context),
+	    context
+	);
+    }
+
+    return rope_node(left, right, context);
+}
+
+ltbs_cell *rope_from_string(ltbs_cell *string, Arena *context)
+{
+    return rope_leaf(string->data.string.strdata, string->data.string.length, context);
+}
+
+size_t rope_length(ltbs_cell *rope)
+{
+    return rope ? rope->data.rope.length : 0;
+}
+
+// Joins along the spine of the taller rope, so the cost is
+// proportional to the difference in heights.
+ltbs_cell *rope_concat(ltbs_cell *rope1, ltbs_cell *rope2, Arena *context)
+{
+    if ( rope1 == 0 ) return rope2;
+    if ( rope2 == 0 ) return rope1;
+
+    size_t length1 = rope1->data.rope.length;
+    size_t length2 = rope2->data.rope.length;
+
+    if ( rope_is_leaf(rope1) && rope_is_leaf(rope2) && (length1 + length2 <= ROPE_LEAF_MERGE) )
+    {
+	byte *buffer = arena_alloc(context, length1 + length2);
+	memcpy(buffer, rope1->data.rope.strdata, length1);
+	memcpy(&buffer[length1], rope2->data.rope.strdata, length2);
+
+	return rope_leaf(buffer, length1 + length2, context);
+    }
+
+    unsigned int height1 = rope1->data.rope.height;
+    unsigned int height2 = rope2->data.rope.height;
+
+    if ( height1 > height2 + 1 )
+	return rope_balance(
+	    rope1->data.rope.left,
+	    rope_concat(rope1->data.rope.right, rope2, context),
+	    context
+	);
+
+    if ( height2 > height1 + 1 )
+	return rope_balance(
+	    rope_concat(rope1, rope2->data.rope.left, context),
+	    rope2->data.rope.right,
+	    context
+	);
+
+    return rope_node(rope1, rope2, context);
+}
+
+void rope_split(ltbs_cell *rope, size_t index, ltbs_cell **left, ltbs_cell **right, Arena *context)
+{
+    size_t length = rope_length(rope);
+
+    if ( index == 0 )
+    {
+	*left = 0;
+	*right = rope;
+	return;
+    }
+
+    if ( index >= length )
+    {
+	*left = rope;
+	*right = 0;
+	return;
+    }
+
+    if ( rope_is_leaf(rope) )
+    {
+	*left = rope_leaf(rope->data.rope.strdata, index, context);
+	*right = rope_leaf(&rope->data.rope.strdata[index], length - index, context);
+	return;
+    }
+
+    ltbs_cell *middle;
+    size_t left_length = rope->data.rope.left->data.rope.length;
+
+    if ( index < left_length )
+    {
+	rope_split(rope->data.rope.left, index, left, &middle, context);
+	*right = rope_concat(middle, rope->data.rope.right, context);
+    }
+
+    else if ( index == left_length )
+    {
+	*left = rope->data.rope.left;
+	*right = rope->data.rope.right;
+    }
+
+    else
+    {
+	rope_split(rope->data.rope.right, index - left_length, &middle, right, context);
+	*left = rope_concat(rope->data.rope.left, middle, context);
+    }
+}
+
+ltbs_cell *rope_insert(ltbs_cell *rope, size_t index, ltbs_cell *to_insert, Arena *context)
+{
+    ltbs_cell *left, *right;
+
+    rope_split(rope, index, &left, &right, context);
+
+    return rope_concat(rope_concat(left, to_insert, context), right, context);
+}
+
+ltbs_cell *rope_remove(ltbs_cell *rope, size_t start, size_t end, Arena *context)
+{
+    ltbs_cell *left, *middle, *right;
+
+    rope_split(rope, end, &middle, &right, context);
+    rope_split(middle, start, &left, &middle, context);
+
+    return rope_concat(left, right, context);
+}
+
+ltbs_cell *rope_substring(ltbs_cell *rope, size_t start, size_t end, Arena *context)
+{
+    ltbs_cell *left, *middle, *right;
+
+    rope_split(rope, end, &middle, &right, context);
+    rope_split(middle, start, &left, &middle, context);
+
+    return middle;
+}
+
+byte rope_at_index(ltbs_cell *rope, size_t index)
+{
+    while ( !rope_is_leaf(rope) )
+    {
+	size_t left_length = rope->data.rope.left->data.rope.length;
+
+	if ( index < left_length )
+	    rope = rope->data.rope.left;
+
+	else
+	{
+	    index -= left_length;
+	    rope = rope->data.rope.right;
+	}
+    }
+
+    return rope->data.rope.strdata[index];
+}
+
+ltbs_rope_iter rope_iter(ltbs_cell *rope)
+{
+    ltbs_rope_iter result;
+    result.top = 0;
+
+    if ( rope != 0 )
+	result.stack[result.top++] = rope;
+
+    return result;
+}
+
+// Fills `chunk` with a string view of the next leaf, left to right.
+int rope_next(ltbs_rope_iter *iter, ltbs_cell *chunk)
+{
+    while ( iter->top > 0 )
+    {
+	ltbs_cell *current = iter->stack[--iter->top];
+
+	if ( rope_is_leaf(current) )
+	{
+	    *chunk = (ltbs_cell) {0};
+	    chunk->type = LTBS_STRING;
+	    chunk->data.string.strdata = current->data.rope.strdata;
+	    chunk->data.string.length = (unsigned int) current->data.rope.length;
+	    return 1;
+	}
+
+	iter->stack[iter->top++] = current->data.rope.right;
+	iter->stack[iter->top++] = current->data.rope.left;
+    }
+
+    return 0;
+}
+
+void rope_for_each(ltbs_cell *rope, chunk_fn callback, void *param)
+{
+    ltbs_rope_iter iter = rope_iter(rope);
+    ltbs_cell chunk;
+
+    while ( rope_next(&iter, &chunk) )
+	callback(chunk.data.string.strdata, chunk.data.string.length, param);
+}
+
+// A single leaf is returned as a view over its bytes, anything else is
+// copied into one NUL-terminated buffer.
+ltbs_cell *rope_flatten(ltbs_cell *rope, Arena *context)
+{
+    if ( (rope != 0) && rope_is_leaf(rope) )
+    {
+	ltbs_cell *result = ltbs_alloc(context);
+	result->type = LTBS_STRING;
+	result->data.string.strdata = rope->data.rope.strdata;
+	result->data.string.length = (unsigned int) rope->data.rope.length;
+	return result;
+    }
+
+    ltbs_string_builder builder = builder_new(rope_length(rope), context);
+
+    if ( rope != 0 )
+	builder_append_cell(&builder, rope);
+
+    return builder_finish(&builder);
+}
+
+#define SEARCH_NOT_FOUND ((size_t) -1)
+
+// Needles up to this length are found with the first/last byte filter,
+// longer ones with Two-Way so that the worst case stays linear.
+#define SEARCH_SHORT_NEEDLE 32
+
+typedef struct string_searcher string_searcher;
+
+struct string_searcher
+{
+    const unsigned char *needle;
+    size_t length;
+    size_t suffix;
+    size_t period;
+    int periodic;
+    int reverse;
+};
+
+// Reads position `index` of the haystack or needle, back to front when
+// the searcher runs in reverse.
+#define SEARCH_AT(buffer, buffer_length, index) \
+    (reverse ? (buffer)[(buffer_length) - 1 - (index)] : (buffer)[index])
+
+// Critical factorization of the needle (Crochemore-Perrin), from the
+// maximal suffixes under both byte orderings.
+static void searcher_prepare_two_way(string_searcher *searcher)
+{
+    const unsigned char *needle = searcher->needle;
+    size_t length = searcher->length;
+    int reverse = searcher->reverse;
+    size_t max_suffix, max_suffix_rev, period, period_rev, j, k;
+
+    max_suffix = SEARCH_NOT_FOUND; j = 0; k = period = 1;
+    while ( j + k < length )
+    {
+	unsigned char a = SEARCH_AT(needle, length, j + k);
+	unsigned char b = SEARCH_AT(needle, length, max_suffix + k);
+
+	if ( a < b ) { j += k; k = 1; period = j - max_suffix; }
+	else if ( a == b ) { if ( k != period ) k++; else { j += period; k = 1; } }
+	else { max_suffix = j++; k = period = 1; }
+    }
+
+    max_suffix_rev = SEARCH_NOT_FOUND; j = 0; k = period_rev = 1;
+    while ( j + k < length )
+    {
+	unsigned char a = SEARCH_AT(needle, length, j + k);
+	unsigned char b = SEARCH_AT(needle, length, max_suffix_rev + k);
+
+	if ( b < a ) { j += k; k = 1; period_rev = j - max_suffix_rev; }
+	else if ( a == b ) { if ( k != period_rev ) k++; else { j += period_rev; k = 1; } }
+	else { max_suffix_rev = j++; k = period_rev = 1; }
+    }
+
+    if ( max_suffix_rev + 1 < max_suffix + 1 )
+	searcher->suffix = max_suffix + 1;
+
+    else
+    {
+	searcher->suffix = max_suffix_rev + 1;
+	period = period_rev;
+    }
+
+    searcher->periodic = 1;
+    for ( size_t index = 0; index < searcher->suffix; index++ )
+	if ( SEARCH_AT(needle, length, index) != SEARCH_AT(needle, length, index + period) )
+	{
+	    searcher->periodic = 0;
+	    break;
+	}
+
+    if ( searcher->periodic )
+	searcher->period = period;
+
+    else
+    {
+	size_t right = length - searcher->suffix;
+	searcher->period = (searcher->suffix > right ? searcher->suffix : right) + 1;
+    }
+}
+
+static string_searcher searcher_new(ltbs_cell *needle, int reverse)
+{
+    string_searcher result = {0};
+
+    result.needle = (const unsigned char *) needle->data.string.strdata;
+    result.length = needle->data.string.length;
+    result.reverse = reverse;
+
+    if ( result.length > SEARCH_SHORT_NEEDLE )
+	searcher_prepare_two_way(&result);
+
+    return result;
+}
+
+static size_t searcher_two_way(string_searcher *searcher, const unsigned char *haystack, size_t haystack_length)
+{
+    const unsigned char *needle = searcher->needle;
+    size_t length = searcher->length;
+    size_t suffix = searcher->suffix;
+    size_t period = searcher->period;
+    int reverse = searcher->reverse;
+    size_t memory = 0;
+    size_t j = 0;
+
+    while ( j <= haystack_length - length )
+    {
+	size_t i = (searcher->periodic && memory > suffix) ? memory : suffix;
+
+	while ( (i < length) &&
+		(SEARCH_AT(needle, length, i) == SEARCH_AT(haystack, haystack_length, i + j)) )
+	    i++;
+
+	if ( i < length )
+	{
+	    j += i - suffix + 1;
+	    memory = 0;
+	    continue;
+	}
+
+	size_t floor = searcher->periodic ? memory : 0;
+	i = suffix;
+
+	while ( (i > floor) &&
+		(SEARCH_AT(needle, length, i - 1) == SEARCH_AT(haystack, haystack_length, i - 1 + j)) )
+	    i--;
+
+	// A periodic needle may resume past the left half entirely, in
+	// which case the scan above never moves and `i` stays above floor.
+	if ( i <= floor )
+	    return reverse ? haystack_length - j - length : j;
+
+	j += period;
+	memory = searcher->periodic ? length - period : 0;
+    }
+
+    return SEARCH_NOT_FOUND;
+}
+
+#undef SEARCH_AT
+
+// Compares only the bytes between the first and the last one, which the
+// filters below have already matched.
+static int searcher_middle_matches(string_searcher *searcher, const unsigned char *candidate)
+{
+    return (searcher->length <= 2) ||
+	(memcmp(candidate + 1, searcher->needle + 1, searcher->length - 2) == 0);
+}
+
+static size_t searcher_short_forward(string_searcher *searcher, const unsigned char *haystack, size_t haystack_length)
+{
+    const unsigned char *needle = searcher->needle;
+    size_t length = searcher->length;
+    size_t last_start = haystack_length - length;
+    size_t index = 0;
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8((char) needle[0]);
+    const __m128i last = _mm_set1_epi8((char) needle[length - 1]);
+
+    for ( ; index + 15 <= last_start; index += 16 )
+    {
+	__m128i block_first = _mm_loadu_si128((const __m128i *) &haystack[index]);
+	__m128i block_last = _mm_loadu_si128((const __m128i *) &haystack[index + length - 1]);
+	unsigned int mask = (unsigned int) _mm_movemask_epi8(
+	    _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))
+	);
+
+	while ( mask != 0 )
+	{
+	    size_t candidate = index + (size_t) __builtin_ctz(mask);
+
+	    if ( searcher_middle_matches(searcher, &haystack[candidate]) )
+		return candidate;
+
+	    mask &= mask - 1;
+	}
+    }
+#endif
+
+    for ( ; index <= last_start; index++ )
+	if ( (haystack[index] == needle[0]) &&
+	     (haystack[index + length - 1] == needle[length - 1]) &&
+	     searcher_middle_matches(searcher, &haystack[index]) )
+	    return index;
+
+    return SEARCH_NOT_FOUND;
+}
+
+static size_t searcher_short_backward(string_searcher *searcher, const unsigned char *haystack, size_t haystack_length)
+{
+    const unsigned char *needle = searcher->needle;
+    size_t length = searcher->length;
+    size_t end = haystack_length - length + 1;
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8((char) needle[0]);
+    const __m128i last = _mm_set1_epi8((char) needle[length - 1]);
+
+    for ( ; end >= 16; end -= 16 )
+    {
+	size_t index = end - 16;
+	__m128i block_first = _mm_loadu_si128((const __m128i *) &haystack[index]);
+	__m128i block_last = _mm_loadu_si128((const __m128i *) &haystack[index + length - 1]);
+	unsigned int mask = (unsigned int) _mm_movemask_epi8(
+	    _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))
+	);
+
+	while ( mask != 0 )
+	{
+	    size_t bit = 31 - (size_t) __builtin_clz(mask);
+
+	    if ( searcher_middle_matches(searcher, &haystack[index + bit]) )
+		return index + bit;
+
+	    mask &= ~(1u << bit);
+	}
+    }
+#endif
+
+    while ( end-- > 0 )
+	if ( (haystack[end] == needle[0]) &&
+	     (haystack[end + length - 1] == needle[length - 1]) &&
+	     searcher_middle_matches(searcher, &haystack[end]) )
+	    return end;
+
+    return SEARCH_NOT_FOUND;
+}
+
+static size_t searcher_run(string_searcher *searcher, const byte *haystack, size_t haystack_length)
+{
+    const unsigned char *bytes = (const unsigned char *) haystack;
+
+    if ( searcher->length > haystack_length )
+	return SEARCH_NOT_FOUND;
+
+    if ( searcher->length > SEARCH_SHORT_NEEDLE )
+	return searcher_two_way(searcher, bytes, haystack_length);
+
+    if ( searcher->reverse )
+	return searcher_short_backward(searcher, bytes, haystack_length);
+
+    if ( searcher->length == 1 )
+    {
+	const byte *found = memchr(haystack, searcher->needle[0], haystack_length);
+	return found ? (size_t) (found - haystack) : SEARCH_NOT_FOUND;
+    }
+
+    return searcher_short_forward(searcher, bytes, haystack_length);
+}
+
+// Index of the first occurrence of `needle` at or after `start`, or -1.
+int64_t string_find(ltbs_cell *string, ltbs_cell *needle, size_t start)
+{
+    size_t length = string->data.string.length;
+
+    if ( start > length )
+	return -1;
+
+    if ( needle->data.string.length == 0 )
+	return (int64_t) start;
+
+    string_searcher searcher = searcher_new(needle, 0);
+    size_t found = searcher_run(&searcher, &string->data.string.strdata[start], length - start);
+
+    return found == SEARCH_NOT_FOUND ? -1 : (int64_t) (start + found);
+}
+
+// Index of the last occurrence of `needle`, or -1.
+int64_t string_rfind(ltbs_cell *string, ltbs_cell *needle)
+{
+    if ( needle->data.string.length == 0 )
+	return string->data.string.length;
+
+    string_searcher searcher = searcher_new(needle, 1);
+    size_t found = searcher_run(&searcher, string->data.string.strdata, string->data.string.length);
+
+    return found == SEARCH_NOT_FOUND ? -1 : (int64_t) found;
+}
+
+// Offsets of all non-overlapping occurrences as an array of uint64_t.
+// An empty needle matches nowhere.
+ltbs_cell *string_find_all(ltbs_cell *string, ltbs_cell *needle, Arena *context)
+{
+    ltbs_string_builder offsets = builder_new(0, context);
+    size_t length = string->data.string.length;
+    size_t step = needle->data.string.length;
+    size_t position = 0;
+
+    if ( step > 0 )
+    {
+	string_searcher searcher = searcher_new(needle, 0);
+	size_t found;
+
+	while ( (found = searcher_run(&searcher, &string->data.string.strdata[position], length - position)) != SEARCH_NOT_FOUND )
+	{
+	    uint64_t offset = position + found;
+	    builder_append_bytes(&offsets, (byte *) &offset, sizeof(offset));
+	    position += found + step;
+	}
+    }
+
+    ltbs_cell *result = builder_finish(&offsets);
+    byte *buffer = result->data.string.strdata;
+    size_t total_size = result->data.string.length;
+
+    result->type = LTBS_ARRAY;
+    result->data.array.buffer = buffer;
+    result->data.array.elem_size = sizeof(uint64_t);
+    result->data.array.total_size = total_size;
+
+    return result;
+}
+
+// Number of non-overlapping occurrences; an empty needle matches nowhere.
+size_t string_count(ltbs_cell *string, ltbs_cell *needle)
+{
+    size_t length = string->data.string.length;
+    size_t step = needle->data.string.length;
+    size_t position = 0;
+    size_t result = 0;
+
+    if ( step == 0 )
+	return 0;
+
+    string_searcher searcher = searcher_new(needle, 0);
+    size_t found;
+
+    while ( (found = searcher_run(&searcher, &string->data.string.strdata[position], length - position)) != SEARCH_NOT_FOUND )
+    {
+	result++;
+	position += found + step;
+    }
+
+    return result;
+}
+
+// Copy of `string` with every non-overlapping occurrence of `needle`
+// replaced, scanning left to right.
+ltbs_cell *string_replace(ltbs_cell *string, ltbs_cell *needle, ltbs_cell *replacement, Arena *context)
+{
+    size_t length = string->data.string.length;
+    size_t step = needle->data.string.length;
+    byte *buffer = string->data.string.strdata;
+    ltbs_string_builder builder = builder_new(length, context);
+    size_t position = 0;
+
+    if ( step > 0 )
+    {
+	string_searcher searcher = searcher_new(needle, 0);
+	size_t found;
+
+	while ( (found = searcher_run(&searcher, &buffer[position], length - position)) != SEARCH_NOT_FOUND )
+	{
+	    builder_append_bytes(&builder, &buffer[position], found);
+	    builder_append_bytes(&builder, replacement->data.string.strdata, replacement->data.string.length);
+	    position += found + step;
+	}
+    }
+
+    builder_append_bytes(&builder, &buffer[position], length - position);
+
+    return builder_finish(&builder);
+}
+
+#define ascii_upcase(value) ((byte) ((unsigned char) ((value) - 'a') < 26 ? (value) ^ 0x20 : (value)))
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+// Flips the case bit of every byte in [first, first + 25]. Shifting the
+// range down to -128 turns the two-sided test into one signed compare.
+static __m128i ascii_fold_block(__m128i block, byte first)
+{
+    __m128i shifted = _mm_add_epi8(block, _mm_set1_epi8((char) (0x80 - first)));
+    __m128i in_range = _mm_cmplt_epi8(shifted, _mm_set1_epi8((char) (0x80 + 26)));
+
+    return _mm_xor_si128(block, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+
+static unsigned int ascii_space_mask(__m128i block)
+{
+    // ' ' plus \t through \r, the same bytes isspace() accepts in "C".
+    __m128i controls = _mm_cmplt_epi8(_mm_sub_epi8(block, _mm_set1_epi8((char) (0x80 + '\t'))),
+				      _mm_set1_epi8((char) (0x80 + 5)));
+    __m128i spaces = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+
+    return (unsigned int) _mm_movemask_epi8(_mm_or_si128(controls, spaces));
+}
+#endif
+
+#define ascii_is_space(value) (((value) == ' ') || ((unsigned char) ((value) - '\t') < 5))
+
+// Copies `length` bytes from `source` to `destination` (which may be the
+// same buffer) with one letter case flipped; `first` is 'a' to upcase
+// and 'A' to downcase.
+static void ascii_fold(byte *destination, const byte *source, size_t length, byte first)
+{
+    size_t index = 0;
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    for ( ; index + 16 <= length; index += 16 )
+    {
+	__m128i block = _mm_loadu_si128((const __m128i *) &source[index]);
+	_mm_storeu_si128((__m128i *) &destination[index], ascii_fold_block(block, first));
+    }
+#endif
+
+    for ( ; index < length; index++ )
+    {
+	byte value = source[index];
+	destination[index] = (byte) ((unsigned char) (value - first) < 26 ? value ^ 0x20 : value);
+    }
+}
+
+static ltbs_cell *string_fold_copy(ltbs_cell *string, byte first, Arena *context)
+{
+    size_t length = string->data.string.length;
+    ltbs_cell *result = string_alloc(length, context);
+
+    ascii_fold(result->data.string.strdata, string->data.string.strdata, length, first);
+
+    return result;
+}
+
+ltbs_cell *string_upcase(ltbs_cell *string, Arena *context)
+{
+    return string_fold_copy(string, 'a', context);
+}
+
+ltbs_cell *string_downcase(ltbs_cell *string, Arena *context)
+{
+    return string_fold_copy(string, 'A', context);
+}
+
+// The bytes change, so a cached hash no longer applies. Interned strings
+// are shared and must not be folded in place.
+void string_upcase_in_place(ltbs_cell *string)
+{
+    ascii_fold(string->data.string.strdata, string->data.string.strdata, string->data.string.length, 'a');
+    string->data.string.flags &= ~LTBS_STRING_HASHED;
+}
+
+void string_downcase_in_place(ltbs_cell *string)
+{
+    ascii_fold(string->data.string.strdata, string->data.string.strdata, string->data.string.length, 'A');
+    string->data.string.flags &= ~LTBS_STRING_HASHED;
+}
+
+// Sets `view` to `string` without leading and trailing ASCII whitespace.
+// No bytes are copied, and `view` may be `string` itself.
+void string_trim(ltbs_cell *string, ltbs_cell *view)
+{
+    byte *bytes = string->data.string.strdata;
+    size_t start = 0;
+    size_t end = string->data.string.length;
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    for ( ; start + 16 <= end; start += 16 )
+    {
+	unsigned int mask = ~ascii_space_mask(_mm_loadu_si128((const __m128i *) &bytes[start])) & 0xFFFF;
+
+	if ( mask != 0 )
+	{
+	    start += (size_t) __builtin_ctz(mask);
+	    break;
+	}
+    }
+
+    for ( ; end >= start + 16; end -= 16 )
+    {
+	unsigned int mask = ~ascii_space_mask(_mm_loadu_si128((const __m128i *) &bytes[end - 16])) & 0xFFFF;
+
+	if ( mask != 0 )
+	{
+	    end -= (size_t) __builtin_clz(mask) - 16;
+	    break;
+	}
+    }
+#endif
+
+    while ( (start < end) && ascii_is_space(bytes[start]) )
+	start++;
+
+    while ( (end > start) && ascii_is_space(bytes[end - 1]) )
+	end--;
+
+    *view = (ltbs_cell) {0};
+    view->type = LTBS_STRING;
+    view->data.string.strdata = &bytes[start];
+    view->data.string.length = (unsigned int) (end - start);
+}
+
+int string_compare_nocase(ltbs_cell *string1, ltbs_cell *string2)
+{
+    if ( string1 == string2 )
+	return 1;
+
+    if ( string1->data.string.length != string2->data.string.length )
+	return 0;
+
+    size_t length = string1->data.string.length;
+    const byte *buffer1 = string1->data.string.strdata;
+    const byte *buffer2 = string2->data.string.strdata;
+    size_t index = 0;
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    for ( ; index + 16 <= length; index += 16 )
+    {
+	__m128i block1 = ascii_fold_block(_mm_loadu_si128((const __m128i *) &buffer1[index]), 'a');
+	__m128i block2 = ascii_fold_block(_mm_loadu_si128((const __m128i *) &buffer2[index]), 'a');
+
+	if ( _mm_movemask_epi8(_mm_cmpeq_epi8(block1, block2)) != 0xFFFF )
+	    return 0;
+    }
+#endif
+
+    for ( ; index < length; index++ )
+	if ( ascii_upcase(buffer1[index]) != ascii_upcase(buffer2[index]) )
+	    return 0;
+
+    return 1;
+}
+
+// Parsing takes the whole string or nothing: an optional sign, then
+// the number, with no surrounding space. Runs of eight digits are read
+// with one multiply-and-shift sequence from Lemire's "Number Parsing at
+// a Gigabyte per Second" (2021) on little-endian targets.
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define LTBS_SWAR_DIGITS
+#endif
+
+#define ascii_is_digit(value) ((unsigned char) ((value) - '0') < 10)
+
+#ifdef LTBS_SWAR_DIGITS
+static int swar_is_eight_digits(uint64_t word)
+{
+    return ((word & 0xF0F0F0F0F0F0F0F0ULL) |
+	    (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+static uint64_t swar_parse_eight_digits(uint64_t word)
+{
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+
+    word -= 0x3030303030303030ULL;
+    word = (word * 10) + (word >> 8);
+
+    return (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+}
+#endif
+
+// Accumulates the digits starting at bytes[*index] into *value, which
+// wraps past 19 digits; returns how many digits were read.
+static size_t parse_digits(const byte *bytes, size_t length, size_t *index, uint64_t *value)
+{
+    size_t cursor = *index;
+    uint64_t result = *value;
+
+#ifdef LTBS_SWAR_DIGITS
+    while ( cursor + 8 <= length )
+    {
+	uint64_t word;
+	memcpy(&word, &bytes[cursor], sizeof(word));
+
+	if ( !swar_is_eight_digits(word) )
+	    break;
+
+	result = result * 100000000 + swar_parse_eight_digits(word);
+	cursor += 8;
+    }
+#endif
+
+    while ( (cursor < length) && ascii_is_digit(bytes[cursor]) )
+    {
+	result = result * 10 + (uint64_t) (bytes[cursor] - '0');
+	cursor++;
+    }
+
+    size_t count = cursor - *index;
+    *index = cursor;
+    *value = result;
+
+    return count;
+}
+
+// Reads the rest of the string from `start` as an unsigned magnitude.
+static int parse_magnitude(const byte *bytes, size_t length, size_t start, uint64_t *out)
+{
+    size_t index = start;
+    uint64_t value = 0;
+
+    while ( (index < length) && (bytes[index] == '0') )
+	index++;
+
+    size_t first = index;
+    size_t count = parse_digits(bytes, length, &index, &value);
+
+    if ( (index != length) || (length == start) || (count > 20) )
+	return 0;
+
+    // Only 20 digit values can overflow; redo them with a check.
+    if ( count == 20 )
+    {
+	uint64_t digit = (uint64_t) (bytes[length - 1] - '0');
+	size_t cursor = first;
+
+	value = 0;
+	parse_digits(bytes, length - 1, &cursor, &value);
+
+	if ( value > (UINT64_MAX - digit) / 10 )
+	    return 0;
+
+	value = value * 10 + digit;
+    }
+
+    *out = value;
+    return 1;
+}
+
+int string_to_uint(ltbs_cell *string, uint64_t *out)
+{
+    const byte *bytes = string->data.string.strdata;
+    size_t length = string->data.string.length;
+    size_t start = (length > 0) && (bytes[0] == '+') ? 1 : 0;
+
+    return parse_magnitude(bytes, length, start, out);
+}
+
+int string_to_int(ltbs_cell *string, int64_t *out)
+{
+    const byte *bytes = string->data.string.strdata;
+    size_t length = string->data.string.length;
+    int negative = (length > 0) && (bytes[0] == '-');
+    size_t start = (length > 0) && ((bytes[0] == '-') || (bytes[0] == '+')) ? 1 : 0;
+    uint64_t magnitude;
+
+    if ( !parse_magnitude(bytes, length, start, &magnitude) )
+	return 0;
+
+    if ( magnitude > (uint64_t) INT64_MAX + negative )
+	return 0;
+
+    *out = negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+    return 1;
+}
+
+static void ltbs_mul128(uint64_t a, uint64_t b, uint64_t *high, uint64_t *low)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128) a * b;
+
+    *high = (uint64_t) (product >> 64);
+    *low = (uint64_t) product;
+#else
+    uint64_t a_low = a & 0xFFFFFFFF, a_high = a >> 32;
+    uint64_t b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+    uint64_t low_low = a_low * b_low;
+    uint64_t high_low = a_high * b_low;
+    uint64_t cross = (low_low >> 32) + (high_low & 0xFFFFFFFF) + a_low * b_high;
+
+    *high = a_high * b_high + (high_low >> 32) + (cross >> 32);
+    *low = (cross << 32) | (low_low & 0xFFFFFFFF);
+#endif
+}
+
+static const double EXACT_POW10[23] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define POW5_SMALLEST -342
+#define POW5_LARGEST 308
+
+// 128-bit truncations of 5^q for q = -342 ... 308, normalized so the top
+// bit is set, as used by Eisel-Lemire.
+static const uint64_t POW5_128[POW5_LARGEST - POW5_SMALLEST + 1][2] =
+{
+    { 0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL }, { 0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL },
+    { 0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL }, { 0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL },
+    { 0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL }, { 0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL },
+    { 0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL }, { 0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL },
+    { 0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL }, { 0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL },
+    { 0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL }, { 0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL },
+    { 0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL }, { 0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL },
+    { 0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL }, { 0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL },
+    { 0x84a57695fe98746dULL, 0x014bb630f7604b57ULL }, { 0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL },
+    { 0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL }, { 0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL },
+    { 0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL }, { 0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL },
+    { 0xfd00b897478238d0ULL, 0x8920b098955522b4ULL }, { 0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL },
+    { 0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL }, { 0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL },
+    { 0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL }, { 0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL },
+    { 0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL }, { 0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL },
+    { 0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL }, { 0xeba09271e88d976bULL, 0xf7864a44c633682eULL },
+    { 0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL }, { 0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL },
+    { 0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL }, { 0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL },
+    { 0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL }, { 0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL },
+    { 0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL }, { 0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL },
+    { 0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL }, { 0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL },
+    { 0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL }, { 0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL },
+    { 0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL }, { 0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL },
+    { 0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL }, { 0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL },
+    { 0xa37fce126597973cULL, 0xe50ff107bab528a0ULL }, { 0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL },
+    { 0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL }, { 0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL },
+    { 0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL }, { 0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL },
+    { 0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL }, { 0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL },
+    { 0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL }, { 0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL },
+    { 0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL }, { 0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL },
+    { 0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL }, { 0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL },
+    { 0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL }, { 0x91376c36d99995beULL, 0x23100809b9c21fa1ULL },
+    { 0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL }, { 0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL },
+    { 0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL }, { 0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL },
+    { 0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL }, { 0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL },
+    { 0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL }, { 0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL },
+    { 0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL }, { 0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL },
+    { 0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL }, { 0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL },
+    { 0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL }, { 0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL },
+    { 0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL }, { 0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL },
+    { 0xc987434744ac874eULL, 0xa327ffb266b56220ULL }, { 0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL },
+    { 0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL }, { 0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL },
+    { 0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL }, { 0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL },
+    { 0xc0314325637a1939ULL, 0xfa911155fefb5308ULL }, { 0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL },
+    { 0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL }, { 0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL },
+    { 0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL }, { 0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL },
+    { 0xb749faed14125d36ULL, 0xcef980ec671f667bULL }, { 0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL },
+    { 0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL }, { 0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL },
+    { 0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL }, { 0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL },
+    { 0xaecc49914078536dULL, 0x58fae9f773886e18ULL }, { 0xda7f5bf590966848ULL, 0xaf39a475506a899eULL },
+    { 0x888f99797a5e012dULL, 0x6d8406c952429603ULL }, { 0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL },
+    { 0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL }, { 0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL },
+    { 0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL }, { 0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL },
+    { 0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL }, { 0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL },
+    { 0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL }, { 0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL },
+    { 0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL }, { 0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL },
+    { 0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL }, { 0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL },
+    { 0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL }, { 0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL },
+    { 0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL }, { 0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL },
+    { 0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL }, { 0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL },
+    { 0xb913179899f68584ULL, 0x28e2557b59846e3fULL }, { 0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL },
+    { 0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL }, { 0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL },
+    { 0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL }, { 0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL },
+    { 0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL }, { 0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL },
+    { 0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL }, { 0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL },
+    { 0xd77485cb25823ac7ULL, 0x7d633293366b828bULL }, { 0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL },
+    { 0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL }, { 0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL },
+    { 0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL }, { 0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL },
+    { 0xcd795be870516656ULL, 0x67902e276c921f8bULL }, { 0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL },
+    { 0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL }, { 0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL },
+    { 0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL }, { 0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL },
+    { 0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL }, { 0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL },
+    { 0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL }, { 0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL },
+    { 0xef340a98172aace4ULL, 0x86fb897116c87c34ULL }, { 0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL },
+    { 0xbae0a846d2195712ULL, 0x8974836059cca109ULL }, { 0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL },
+    { 0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL }, { 0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL },
+    { 0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL }, { 0x8e938662882af53eULL, 0x547eb47b7282ee9cULL },
+    { 0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL }, { 0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL },
+    { 0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL }, { 0xae0b158b4738705eULL, 0x9624ab50b148d445ULL },
+    { 0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL }, { 0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL },
+    { 0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL }, { 0xd47487cc8470652bULL, 0x7647c3200069671fULL },
+    { 0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL }, { 0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL },
+    { 0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL }, { 0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL },
+    { 0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL }, { 0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL },
+    { 0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL }, { 0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL },
+    { 0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL }, { 0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL },
+    { 0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL }, { 0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL },
+    { 0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL }, { 0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL },
+    { 0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL }, { 0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL },
+    { 0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL }, { 0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL },
+    { 0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL }, { 0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL },
+    { 0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL }, { 0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL },
+    { 0x8c974f7383725573ULL, 0x1e414218c73a13fbULL }, { 0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL },
+    { 0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL }, { 0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL },
+    { 0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL }, { 0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL },
+    { 0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL }, { 0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL },
+    { 0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL }, { 0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL },
+    { 0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL }, { 0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL },
+    { 0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL }, { 0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL },
+    { 0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL }, { 0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL },
+    { 0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL }, { 0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL },
+    { 0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL }, { 0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL },
+    { 0xbe89523386091465ULL, 0xf6bbb397f1135823ULL }, { 0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL },
+    { 0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL }, { 0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL },
+    { 0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL }, { 0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL },
+    { 0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL }, { 0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL },
+    { 0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL }, { 0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL },
+    { 0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL }, { 0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL },
+    { 0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL }, { 0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL },
+    { 0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL }, { 0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL },
+    { 0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL }, { 0x843610cb4bf160cbULL, 0xcedf722a585139baULL },
+    { 0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL }, { 0xce947a3da6a9273eULL, 0x733d226229feea32ULL },
+    { 0x811ccc668829b887ULL, 0x0806357d5a3f525fULL }, { 0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL },
+    { 0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL }, { 0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL },
+    { 0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL }, { 0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL },
+    { 0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL }, { 0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL },
+    { 0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL }, { 0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL },
+    { 0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL }, { 0xbbe226efb628afeaULL, 0x890489f70a55368bULL },
+    { 0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL }, { 0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL },
+    { 0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL }, { 0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL },
+    { 0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL }, { 0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL },
+    { 0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL }, { 0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL },
+    { 0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL }, { 0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL },
+    { 0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL }, { 0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL },
+    { 0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL }, { 0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL },
+    { 0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL }, { 0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL },
+    { 0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL }, { 0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL },
+    { 0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL }, { 0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL },
+    { 0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL }, { 0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL },
+    { 0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL }, { 0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL },
+    { 0xc24452da229b021bULL, 0xfbe85badce996168ULL }, { 0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL },
+    { 0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL }, { 0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL },
+    { 0xed246723473e3813ULL, 0x290123e9aab23b68ULL }, { 0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL },
+    { 0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL }, { 0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL },
+    { 0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL }, { 0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL },
+    { 0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL }, { 0x8d590723948a535fULL, 0x579c487e5a38ad0eULL },
+    { 0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL }, { 0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL },
+    { 0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL }, { 0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL },
+    { 0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL }, { 0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL },
+    { 0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL }, { 0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL },
+    { 0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL }, { 0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL },
+    { 0xcdb02555653131b6ULL, 0x3792f412cb06794dULL }, { 0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL },
+    { 0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL }, { 0xc8de047564d20a8bULL, 0xf245825a5a445275ULL },
+    { 0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL }, { 0x9ced737bb6c4183dULL, 0x55464dd69685606bULL },
+    { 0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL }, { 0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL },
+    { 0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL }, { 0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL },
+    { 0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL }, { 0x95a8637627989aadULL, 0xdde7001379a44aa8ULL },
+    { 0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL }, { 0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL },
+    { 0x9226712162ab070dULL, 0xcab3961304ca70e8ULL }, { 0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL },
+    { 0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL }, { 0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL },
+    { 0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL }, { 0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL },
+    { 0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL }, { 0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL },
+    { 0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL }, { 0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL },
+    { 0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL }, { 0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL },
+    { 0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL }, { 0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL },
+    { 0xcfb11ead453994baULL, 0x67de18eda5814af2ULL }, { 0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL },
+    { 0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL }, { 0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL },
+    { 0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL }, { 0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL },
+    { 0xc612062576589ddaULL, 0x95364afe032a819eULL }, { 0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL },
+    { 0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL }, { 0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL },
+    { 0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL }, { 0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL },
+    { 0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL }, { 0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL },
+    { 0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL }, { 0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL },
+    { 0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL }, { 0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL },
+    { 0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL }, { 0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL },
+    { 0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL }, { 0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL },
+    { 0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL }, { 0x89705f4136b4a597ULL, 0x31680a88f8953031ULL },
+    { 0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL }, { 0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL },
+    { 0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL }, { 0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL },
+    { 0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL }, { 0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL },
+    { 0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL }, { 0xccccccccccccccccULL, 0xcccccccccccccccdULL },
+    { 0x8000000000000000ULL, 0x0000000000000000ULL }, { 0xa000000000000000ULL, 0x0000000000000000ULL },
+    { 0xc800000000000000ULL, 0x0000000000000000ULL }, { 0xfa00000000000000ULL, 0x0000000000000000ULL },
+    { 0x9c40000000000000ULL, 0x0000000000000000ULL }, { 0xc350000000000000ULL, 0x0000000000000000ULL },
+    { 0xf424000000000000ULL, 0x0000000000000000ULL }, { 0x9896800000000000ULL, 0x0000000000000000ULL },
+    { 0xbebc200000000000ULL, 0x0000000000000000ULL }, { 0xee6b280000000000ULL, 0x0000000000000000ULL },
+    { 0x9502f90000000000ULL, 0x0000000000000000ULL }, { 0xba43b74000000000ULL, 0x0000000000000000ULL },
+    { 0xe8d4a51000000000ULL, 0x0000000000000000ULL }, { 0x9184e72a00000000ULL, 0x0000000000000000ULL },
+    { 0xb5e620f480000000ULL, 0x0000000000000000ULL }, { 0xe35fa931a0000000ULL, 0x0000000000000000ULL },
+    { 0x8e1bc9bf04000000ULL, 0x0000000000000000ULL }, { 0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL },
+    { 0xde0b6b3a76400000ULL, 0x0000000000000000ULL }, { 0x8ac7230489e80000ULL, 0x0000000000000000ULL },
+    { 0xad78ebc5ac620000ULL, 0x0000000000000000ULL }, { 0xd8d726b7177a8000ULL, 0x0000000000000000ULL },
+    { 0x878678326eac9000ULL, 0x0000000000000000ULL }, { 0xa968163f0a57b400ULL, 0x0000000000000000ULL },
+    { 0xd3c21bcecceda100ULL, 0x0000000000000000ULL }, { 0x84595161401484a0ULL, 0x0000000000000000ULL },
+    { 0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL }, { 0xcecb8f27f4200f3aULL, 0x0000000000000000ULL },
+    { 0x813f3978f8940984ULL, 0x4000000000000000ULL }, { 0xa18f07d736b90be5ULL, 0x5000000000000000ULL },
+    { 0xc9f2c9cd04674edeULL, 0xa400000000000000ULL }, { 0xfc6f7c4045812296ULL, 0x4d00000000000000ULL },
+    { 0x9dc5ada82b70b59dULL, 0xf020000000000000ULL }, { 0xc5371912364ce305ULL, 0x6c28000000000000ULL },
+    { 0xf684df56c3e01bc6ULL, 0xc732000000000000ULL }, { 0x9a130b963a6c115cULL, 0x3c7f400000000000ULL },
+    { 0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL }, { 0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL },
+    { 0x96769950b50d88f4ULL, 0x1314448000000000ULL }, { 0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL },
+    { 0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL }, { 0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL },
+    { 0xb7abc627050305adULL, 0xf14a3d9e40000000ULL }, { 0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL },
+    { 0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL }, { 0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL },
+    { 0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL }, { 0x8c213d9da502de45ULL, 0x4526f422cc340000ULL },
+    { 0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL }, { 0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL },
+    { 0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL }, { 0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL },
+    { 0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL }, { 0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL },
+    { 0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL }, { 0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL },
+    { 0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL }, { 0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL },
+    { 0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL }, { 0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL },
+    { 0x9f4f2726179a2245ULL, 0x01d762422c946590ULL }, { 0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL },
+    { 0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL }, { 0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL },
+    { 0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL }, { 0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL },
+    { 0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL }, { 0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL },
+    { 0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL }, { 0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL },
+    { 0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL }, { 0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL },
+    { 0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL }, { 0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL },
+    { 0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL }, { 0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL },
+    { 0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL }, { 0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL },
+    { 0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL }, { 0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL },
+    { 0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL }, { 0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL },
+    { 0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL }, { 0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL },
+    { 0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL }, { 0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL },
+    { 0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL }, { 0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL },
+    { 0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL }, { 0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL },
+    { 0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL }, { 0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL },
+    { 0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL }, { 0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL },
+    { 0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL }, { 0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL },
+    { 0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL }, { 0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL },
+    { 0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL }, { 0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL },
+    { 0x924d692ca61be758ULL, 0x593c2626705f9c56ULL }, { 0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL },
+    { 0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL }, { 0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL },
+    { 0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL }, { 0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL },
+    { 0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL }, { 0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL },
+    { 0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL }, { 0x884134fe908658b2ULL, 0x3109058d147fdcddULL },
+    { 0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL }, { 0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL },
+    { 0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL }, { 0xa6539930bf6bff45ULL, 0x84db8346b786151cULL },
+    { 0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL }, { 0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL },
+    { 0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL }, { 0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL },
+    { 0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL }, { 0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL },
+    { 0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL }, { 0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL },
+    { 0x9ae757596946075fULL, 0x3375788de9b06958ULL }, { 0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL },
+    { 0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL }, { 0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL },
+    { 0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL }, { 0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL },
+    { 0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL }, { 0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL },
+    { 0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL }, { 0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL },
+    { 0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL }, { 0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL },
+    { 0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL }, { 0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL },
+    { 0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL }, { 0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL },
+    { 0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL }, { 0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL },
+    { 0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL }, { 0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL },
+    { 0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL }, { 0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL },
+    { 0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL }, { 0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL },
+    { 0x802221226be55a64ULL, 0xc2494954da2c9789ULL }, { 0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL },
+    { 0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL }, { 0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL },
+    { 0x9c69a97284b578d7ULL, 0xff2a760414536efbULL }, { 0xc38413cf25e2d70dULL, 0xfef5138519684abaULL },
+    { 0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL }, { 0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL },
+    { 0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL }, { 0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL },
+    { 0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL }, { 0xba756174393d88dfULL, 0x94f971119aeef9e4ULL },
+    { 0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL }, { 0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL },
+    { 0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL }, { 0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL },
+    { 0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL }, { 0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL },
+    { 0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL }, { 0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL },
+    { 0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL }, { 0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL },
+    { 0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL }, { 0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL },
+    { 0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL }, { 0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL },
+    { 0xa59bc234db398c25ULL, 0x43fab9837e699095ULL }, { 0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL },
+    { 0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL }, { 0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL },
+    { 0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL }, { 0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL },
+    { 0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL }, { 0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL },
+    { 0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL }, { 0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL },
+    { 0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL }, { 0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL },
+    { 0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL }, { 0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL },
+    { 0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL }, { 0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL },
+    { 0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL }, { 0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL },
+    { 0x8fa475791a569d10ULL, 0xf96e017d694487bcULL }, { 0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL },
+    { 0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL }, { 0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL },
+    { 0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL }, { 0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL },
+    { 0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL }, { 0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL },
+    { 0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL }, { 0x85c7056562757456ULL, 0xf6872d5667844e49ULL },
+    { 0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL }, { 0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL },
+    { 0x82a45b450226b39cULL, 0xecc0024661173473ULL }, { 0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL },
+    { 0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL }, { 0xff290242c83396ceULL, 0x7e67047175a15271ULL },
+    { 0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL }, { 0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL },
+    { 0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL }, { 0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL },
+    { 0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL }, { 0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL },
+    { 0x98165af37b2153deULL, 0xc3727a337a8b704aULL }, { 0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL },
+    { 0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL }, { 0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL },
+    { 0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL }, { 0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL },
+    { 0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL }, { 0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL },
+    { 0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL }, { 0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL },
+    { 0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL }, { 0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL },
+    { 0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL }, { 0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL },
+    { 0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL }, { 0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL },
+    { 0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL }, { 0xd31045a8341ca07cULL, 0x1ede48111209a050ULL },
+    { 0x83ea2b892091e44dULL, 0x934aed0aab460432ULL }, { 0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL },
+    { 0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL }, { 0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL },
+    { 0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL }, { 0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL },
+    { 0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL }, { 0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL },
+    { 0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL }, { 0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL },
+    { 0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL }, { 0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL },
+    { 0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL }, { 0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL },
+    { 0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL }, { 0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL },
+    { 0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL }, { 0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL },
+    { 0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL }, { 0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL },
+    { 0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL }, { 0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL },
+    { 0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL }, { 0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL },
+    { 0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL }, { 0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL },
+    { 0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL }, { 0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL },
+    { 0x8533285c936b35deULL, 0xd53a88958f87275fULL }, { 0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL },
+    { 0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL }, { 0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL },
+    { 0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL }, { 0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL },
+    { 0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL }, { 0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL },
+    { 0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL }, { 0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL },
+    { 0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL }, { 0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL },
+    { 0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL }, { 0x976e41088617ca01ULL, 0xd5be0503e085d813ULL },
+    { 0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL }, { 0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL },
+    { 0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL }, { 0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL },
+    { 0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL }, { 0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL },
+    { 0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL }, { 0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL },
+    { 0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL }, { 0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL },
+    { 0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL }, { 0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL },
+    { 0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL }, { 0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL },
+    { 0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL }, { 0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL },
+    { 0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL }, { 0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL },
+    { 0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL }, { 0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL },
+    { 0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL }, { 0xa0555e361951c366ULL, 0xd7e105bcc332621fULL },
+    { 0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL }, { 0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL },
+    { 0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL }, { 0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL },
+    { 0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL }, { 0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL },
+    { 0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL }, { 0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL },
+    { 0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL }, { 0xbaa718e68396cffdULL, 0xd30560258f54e6baULL },
+    { 0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL }, { 0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL },
+    { 0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL }, { 0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL },
+    { 0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL }
+};
+
+// Daniel Lemire, "Number Parsing at a Gigabyte per Second" (2021), after
+// Michael Eisel: the binary64 bits nearest to w * 10^q from one or two
+// 64x64 multiplications. Returns 0 in the rare case the truncated
+// product cannot decide the rounding.
+static int eisel_lemire(uint64_t w, int64_t q, uint64_t *bits)
+{
+    if ( (w == 0) || (q < POW5_SMALLEST) )
+    {
+	*bits = 0;
+	return 1;
+    }
+
+    if ( q > POW5_LARGEST )
+    {
+	*bits = (uint64_t) 0x7FF << 52;
+	return 1;
+    }
+
+    int leading_zeros = __builtin_clzll(w);
+    const uint64_t *power = POW5_128[q - POW5_SMALLEST];
+    uint64_t high, low;
+
+    w <<= leading_zeros;
+    ltbs_mul128(w, power[0], &high, &low);
+
+    // The low bits decide rounding only when all of them are set.
+    if ( (high & 0x1FF) == 0x1FF )
+    {
+	uint64_t second_high, second_low;
+	ltbs_mul128(w, power[1], &second_high, &second_low);
+
+	low += second_high;
+
+	if ( second_high > low )
+	    high++;
+    }
+
+    if ( (low == UINT64_MAX) && ((q < -27) || (q > 55)) )
+	return 0;
+
+    int upper_bit = (int) (high >> 63);
+    uint64_t mantissa = high >> (upper_bit + 9);
+    int64_t power2 = (((152170 + 65536) * q) >> 16) + 63 + upper_bit - leading_zeros + 1023;
+
+    if ( power2 <= 0 )
+    {
+	if ( -power2 + 1 >= 64 )
+	{
+	    *bits = 0;
+	    return 1;
+	}
+
+	// Subnormal: shift into place and round, possibly up to the
+	// smallest normal.
+	mantissa >>= -power2 + 1;
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+
+	*bits = mantissa;
+	return 1;
+    }
+
+    // Exactly halfway between two doubles: round to even.
+    if ( (low <= 1) && (q >= -4) && (q <= 23) && ((mantissa & 3) == 1) &&
+	 ((mantissa << (upper_bit + 9)) == high) )
+	mantissa &= ~(uint64_t) 1;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+
+    if ( mantissa >= ((uint64_t) 2 << 52) )
+    {
+	mantissa = (uint64_t) 1 << 52;
+	power2++;
+    }
+
+    if ( power2 >= 0x7FF )
+    {
+	*bits = (uint64_t) 0x7FF << 52;
+	return 1;
+    }
+
+    *bits = (mantissa & (((uint64_t) 1 << 52) - 1)) | ((uint64_t) power2 << 52);
+    return 1;
+}
+
+static int ascii_equal_nocase(const byte *bytes, size_t length, const char *word)
+{
+    if ( length != strlen(word) )
+	return 0;
+
+    for ( size_t index = 0; index < length; index++ )
+	if ( ascii_upcase(bytes[index]) != ascii_upcase(word[index]) )
+	    return 0;
+
+    return 1;
+}
+
+// Accepts what strtod() accepts in the "C" locale for decimal input,
+// including inf, infinity and nan, but not hexadecimal floats.
+int string_to_double(ltbs_cell *string, double *out)
+{
+    const byte *bytes = string->data.string.strdata;
+    size_t length = string->data.string.length;
+    size_t index = 0;
+    int negative = 0;
+
+    if ( (length > 0) && ((bytes[0] == '-') || (bytes[0] == '+')) )
+    {
+	negative = bytes[0] == '-';
+	index++;
+    }
+
+    int is_infinity = ascii_equal_nocase(&bytes[index], length - index, "inf") ||
+	ascii_equal_nocase(&bytes[index], length - index, "infinity");
+
+    if ( is_infinity || ascii_equal_nocase(&bytes[index], length - index, "nan") )
+    {
+	uint64_t special = is_infinity ? (uint64_t) 0x7FF << 52 : (uint64_t) 0xFFF << 51;
+
+	special |= (uint64_t) negative << 63;
+	memcpy(out, &special, sizeof(special));
+	return 1;
+    }
+
+    size_t digits_start = index;
+    uint64_t mantissa = 0;
+    size_t digit_count = parse_digits(bytes, length, &index, &mantissa);
+    size_t fraction_digits = 0;
+
+    if ( (index < length) && (bytes[index] == '.') )
+    {
+	index++;
+	fraction_digits = parse_digits(bytes, length, &index, &mantissa);
+	digit_count += fraction_digits;
+    }
+
+    if ( digit_count == 0 )
+	return 0;
+
+    size_t digits_end = index;
+    int64_t exponent = 0;
+
+    if ( (index < length) && ((bytes[index] == 'e') || (bytes[index] == 'E')) )
+    {
+	int exponent_negative = 0;
+	index++;
+
+	if ( (index < length) && ((bytes[index] == '-') || (bytes[index] == '+')) )
+	    exponent_negative = bytes[index++] == '-';
+
+	if ( (index >= length) || !ascii_is_digit(bytes[index]) )
+	    return 0;
+
+	// Past this every nonzero mantissa is already zero or infinite.
+	for ( ; (index < length) && ascii_is_digit(bytes[index]); index++ )
+	    if ( exponent < 0x10000 )
+		exponent = exponent * 10 + (bytes[index] - '0');
+
+	if ( exponent_negative )
+	    exponent = -exponent;
+    }
+
+    if ( index != length )
+	return 0;
+
+    exponent -= (int64_t) fraction_digits;
+
+    // Over 19 digits the mantissa wrapped; keep the first 19 significant
+    // ones and move the rest into the exponent.
+    int truncated = 0;
+
+    if ( digit_count > 19 )
+    {
+	size_t taken = 0;
+	size_t dropped = 0;
+
+	mantissa = 0;
+
+	for ( size_t cursor = digits_start; cursor < digits_end; cursor++ )
+	{
+	    if ( bytes[cursor] == '.' )
+		continue;
+
+	    if ( taken == 19 )
+	    {
+		dropped++;
+		truncated |= bytes[cursor] != '0';
+	    }
+
+	    else if ( (taken > 0) || (bytes[cursor] != '0') )
+	    {
+		mantissa = mantissa * 10 + (uint64_t) (bytes[cursor] - '0');
+		taken++;
+	    }
+	}
+
+	exponent += (int64_t) dropped;
+    }
+
+    double value;
+    uint64_t bits;
+    uint64_t upper_bits;
+
+    // Clinger's fast path: both operands and the result are exact.
+    if ( !truncated && (mantissa <= ((uint64_t) 1 << 53)) && (exponent >= -22) && (exponent <= 22) )
+    {
+	value = (double) mantissa;
+	value = exponent < 0 ? value / EXACT_POW10[-exponent] : value * EXACT_POW10[exponent];
+    }
+
+    // A truncated mantissa is good when rounding it up changes nothing.
+    else if ( eisel_lemire(mantissa, exponent, &bits) &&
+	      (!truncated || (eisel_lemire(mantissa + 1, exponent, &upper_bits) && (upper_bits == bits))) )
+	memcpy(&value, &bits, sizeof(value));
+
+    else
+    {
+	// Undecidable from 19 digits; let the C library read them all.
+	char buffer[128];
+	char *copy = length < sizeof(buffer) ? buffer : malloc(length + 1);
+
+	// Without room for the copy the input cannot be read at all.
+	if ( copy == 0 )
+	    return 0;
+
+	memcpy(copy, bytes, length);
+	copy[length] = '\0';
+	value = strtod(copy, 0);
+
+	if ( copy != buffer )
+	    free(copy);
+
+	*out = value;
+	return 1;
+    }
+
+    *out = negative ? -value : value;
+    return 1;
+}
+
+ltbs_cell *int_to_string(int64_t value, Arena *context)
+{
+    byte digits[21];
+    byte *end = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    byte *start = ltbs_write_uint(end, magnitude);
+
+    if ( value < 0 )
+	*--start = '-';
+
+    ltbs_cell *result = string_alloc((size_t) (end - start), context);
+    memcpy(result->data.string.strdata, start, (size_t) (end - start));
+
+    return result;
+}
+
+ltbs_cell *uint_to_string(uint64_t value, Arena *context)
+{
+    byte digits[20];
+    byte *end = digits + sizeof(digits);
+    byte *start = ltbs_write_uint(end, value);
+
+    ltbs_cell *result = string_alloc((size_t) (end - start), context);
+    memcpy(result->data.string.strdata, start, (size_t) (end - start));
+
+    return result;
+}
+
+// Shortest digits that read back as the same double.
+ltbs_cell *double_to_string(double value, Arena *context)
+{
+    byte digits[32];
+    int length = ltbs_write_double(digits, value);
+
+    ltbs_cell *result = string_alloc((size_t) length, context);
+    memcpy(result->data.string.strdata, digits, (size_t) length);
+
+    return result;
+}
+
+ltbs_cell *array_new(size_t elem_size, size_t total_size, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context);
+    char *buffer = arena_alloc(context, total_size);
+    
+    result->data.array.elem_size = elem_size;
+    result->data.array.total_size = total_size;
+    result->data.array.buffer = buffer;
+
+    for ( size_t index = 0; index < total_size; index++ ) buffer[index] = 0;
+
+    return result;
+}
+
+ltbs_cell *array_to_list(ltbs_cell *array, Arena *context)
+{
+    ltbs_cell *result = List_Vt.nil();
+    size_t total = array->data.array.total_size;
+    size_t elem_size = array->data.array.elem_size;
+    int length = total / elem_size;
+
+    for ( int index = 0; index < length; index++ )
+    {
+	ltbs_cell *to_add = ltbs_alloc(context);
+	to_add->type = LTBS_CUSTOM;
+	to_add->data.custom.data = &array->data.array.buffer[index * elem_size];
+	to_add->data.custom.size = elem_size;
+
+	result = List_Vt.cons(to_add, result, context);
+    }
+
+    return result;
+}
+
+void *array_ref(ltbs_cell *array, unsigned int index)
+{
+    void *result;
+    size_t offset = array->data.array.elem_size * index;
+
+    if ( offset > array->data.array.total_size )
+	return 0;
+
+    result = &array->data.array.buffer[offset];
+    
+    return result;
+}
+
+// An inline string's bytes move with the cell, so `copy`, a byte copy
+// of `original`, must point at its own inline buffer. Only a string that
+// points into its own cell is touched, which leaves other elements of
+// the same size alone.
+static void cell_copy_inline(ltbs_cell *copy, const ltbs_cell *original)
+{
+    if ( (original->type == LTBS_STRING) &&
+	 (original->data.string.flags & LTBS_STRING_INLINE) &&
+	 (original->data.string.strdata == original->data.string.inline_data) )
+	copy->data.string.strdata = copy->data.string.inline_data;
+}
+
+ltbs_cell *pair_to_array(ltbs_cell *list, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context);
+    int length = pair_length(list);
+    ltbs_cell *buffer = arena_alloc(context, sizeof(ltbs_cell) * length);
+    size_t elem = sizeof(ltbs_cell);
+    size_t total = elem * length;
+    ltbs_cell *tracker = list;
+
+    result->type = LTBS_ARRAY;
+    result->data.array.elem_size = elem;
+    result->data.array.total_size = total;
+    result->data.array.buffer = buffer;
+
+    for ( int index = 0; index < length; index++ )
+    {
+	buffer[index] = *pair_head(tracker);
+	cell_copy_inline(&buffer[index], pair_head(tracker));
+	tracker = pair_rest(tracker);
+    }
+
+    return result;
+}
+
+/* ltbs_cell *array_reverse(ltbs_cell *array, Arena *context) */
+/* { */
+/*     ltbs_cell *result = ltbs_alloc(context); */
+/*     int length = array->data.array.length; */
+/*     ltbs_cell **buffer = arena_alloc(context, sizeof(ltbs_cell*) * length); */
+/*     int inner_index = length; */
+
+/*     result->type = LTBS_ARRAY; */
+/*     result->data.array.arrdata = buffer; */
+/*     result->data.array.length = length; */
+    
+/*     for (int index = 0; index < length; index++) */
+/* 	buffer[index] = array->data.array.arrdata[inner_index--]; */
+
+/*     return result; */
+/* } */
+
+ltbs_cell array_slice(ltbs_cell *array, int start, int end)
+{
+    size_t offset = array->data.array.elem_size * start;
+    size_t total = array->data.array.elem_size * end;
+    void *buffer = &array->data.array.buffer[offset];
+    
+    return (ltbs_cell)
+    {
+	.type = LTBS_ARRAY,
+	.data.array = (ltbs_array)
+	{
+	    .buffer = buffer,
+	    .elem_size = array->data.array.elem_size,
+	    .total_size = total
+	}
+    };
+}
+
+/* ltbs_cell *array_append(ltbs_cell *array1, ltbs_cell *array2, Arena *context) */
+/* { */
+/*     ltbs_cell *result = ltbs_alloc(context); */
+/*     int length1 = array1->data.array.length; */
+/*     int length2 = array2->data.array.length; */
 /*     int length_total = length1 + length2; */
 /*     ltbs_cell **buffer = arena_alloc(context, sizeof(ltbs_cell*) * length_total); */
     
-/*     result->type = LTBS_ARRAY; */
-/*     result->data.array.length = length_total; */
-/*     result->data.array.arrdata = buffer; */
+/*     result->type = LTBS_ARRAY; */
+/*     result->data.array.length = length_total; */
+/*     result->data.array.arrdata = buffer; */
+
+/*     for (int index = 0; index < length_total; index++) */
+/*     { */
+/* 	if ( index < length1 ) */
+/* 	    buffer[index] = array1->data.array.arrdata[index]; */
+/* 	else */
+/* 	    buffer[index + length1] = array2->data.array.arrdata[index - length1]; */
+/*     } */
+
+/*     return result; */
+/* } */
+
+ltbs_cell *array_copy(ltbs_cell *array, Arena *destination)
+{
+    int length = array->data.array.total_size / array->data.array.elem_size;
+    int total_buffer_size = array->data.array.total_size;
+    char *buffer = array->data.array.buffer;
+    char *dest_buffer = arena_alloc(destination, total_buffer_size);
+    ltbs_cell *result = ltbs_alloc(destination);
+
+    result->type = LTBS_ARRAY;
+    result->data.array.elem_size = array->data.array.elem_size;
+    result->data.array.total_size = array->data.array.total_size;
+    result->data.array.buffer = dest_buffer;
+
+    for ( int index = 0; index < total_buffer_size; index++ )
+	dest_buffer[index] = buffer[index];
+
+    if ( array->data.array.elem_size == sizeof(ltbs_cell) )
+	for ( int index = 0; index < length; index++ )
+	    cell_copy_inline(&((ltbs_cell *) dest_buffer)[index], &((ltbs_cell *) buffer)[index]);
+
+    return result;
+}
+
+void array_set_index(ltbs_cell *array, void *value, int index)
+{
+    size_t offset = array->data.array.elem_size * index;
+    size_t elem = array->data.array.elem_size;
+    char *as_buffer = value;
+    char *destination = array->data.array.buffer;
+
+    for ( size_t index = 0; index < elem; index++ )
+	destination[offset + index] = as_buffer[index];
+
+    if ( elem == sizeof(ltbs_cell) )
+	cell_copy_inline((ltbs_cell *) &destination[offset], value);
+}
+
+ltbs_cell *hash_make(Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context);
+    result->type = LTBS_HASHMAP;
+    result->data.hashmap.children[0] = 0;
+    result->data.hashmap.children[1] = 0;
+    result->data.hashmap.children[2] = 0;
+    result->data.hashmap.children[3] = 0;
+    result->data.hashmap.value = 0;
+    result->data.hashmap.key = 0;
+
+    return result;
+}
+
+// After wyhash (final version 4) by Wang Yi, public domain: 48 bytes per
+// step in three independent 64x64->128 multiply lanes. The trie walks
+// hashes from the top two bits down, and these are as well mixed as the
+// rest. Loads are in native byte order, so hashes are not portable
+// between machines of different endianness.
+static const uint64_t WYHASH_SECRET[4] =
+{
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+static uint64_t wyhash_mix(uint64_t a, uint64_t b)
+{
+    uint64_t high, low;
+    ltbs_mul128(a, b, &high, &low);
+
+    return high ^ low;
+}
+
+// Upcases the ASCII letters among eight bytes at once.
+static uint64_t swar_upcase(uint64_t word)
+{
+    const uint64_t ones = 0x0101010101010101ULL;
+    uint64_t heptets = word & (0x7F * ones);
+    uint64_t above_z = heptets + (0x7F - 'z') * ones;
+    uint64_t from_a = heptets + (0x80 - 'a') * ones;
+    uint64_t lower = ~word & (from_a ^ above_z) & (0x80 * ones);
+
+    return word ^ (lower >> 2);
+}
+
+static uint64_t wyhash_read8(const byte *bytes, int fold)
+{
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+
+    return fold ? swar_upcase(word) : word;
+}
+
+static uint64_t wyhash_read4(const byte *bytes, int fold)
+{
+    uint32_t word;
+    memcpy(&word, bytes, sizeof(word));
+
+    return fold ? swar_upcase(word) : word;
+}
+
+static uint64_t wyhash_read3(const byte *bytes, size_t length, int fold)
+{
+    byte first = bytes[0], middle = bytes[length >> 1], last = bytes[length - 1];
+
+    if ( fold )
+    {
+	first = ascii_upcase(first);
+	middle = ascii_upcase(middle);
+	last = ascii_upcase(last);
+    }
+
+    return ((uint64_t) (unsigned char) first << 16) | ((uint64_t) (unsigned char) middle << 8) | (unsigned char) last;
+}
+
+// With `fold` set, hashes the bytes as if they were upcased. The flag
+// is a constant at both call sites, so each gets its own copy.
+static inline __attribute__((always_inline))
+uint64_t wyhash(const byte *bytes, size_t length, uint64_t seed, int fold)
+{
+    const uint64_t *secret = WYHASH_SECRET;
+    uint64_t a, b;
+
+    seed ^= wyhash_mix(seed ^ secret[0], secret[1]);
+
+    if ( length <= 16 )
+    {
+	if ( length >= 4 )
+	{
+	    size_t quarter = (length >> 3) << 2;
+
+	    a = (wyhash_read4(bytes, fold) << 32) | wyhash_read4(bytes + quarter, fold);
+	    b = (wyhash_read4(bytes + length - 4, fold) << 32) | wyhash_read4(bytes + length - 4 - quarter, fold);
+	}
+
+	else if ( length > 0 )
+	{
+	    a = wyhash_read3(bytes, length, fold);
+	    b = 0;
+	}
+
+	else a = b = 0;
+    }
+
+    else
+    {
+	size_t remaining = length;
+
+	if ( remaining >= 48 )
+	{
+	    uint64_t seed1 = seed, seed2 = seed;
+
+	    do
+	    {
+		seed = wyhash_mix(wyhash_read8(bytes, fold) ^ secret[1], wyhash_read8(bytes + 8, fold) ^ seed);
+		seed1 = wyhash_mix(wyhash_read8(bytes + 16, fold) ^ secret[2], wyhash_read8(bytes + 24, fold) ^ seed1);
+		seed2 = wyhash_mix(wyhash_read8(bytes + 32, fold) ^ secret[3], wyhash_read8(bytes + 40, fold) ^ seed2);
+		bytes += 48;
+		remaining -= 48;
+	    } while ( remaining >= 48 );
+
+	    seed ^= seed1 ^ seed2;
+	}
+
+	while ( remaining > 16 )
+	{
+	    seed = wyhash_mix(wyhash_read8(bytes, fold) ^ secret[1], wyhash_read8(bytes + 8, fold) ^ seed);
+	    bytes += 16;
+	    remaining -= 16;
+	}
+
+	a = wyhash_read8(bytes + remaining - 16, fold);
+	b = wyhash_read8(bytes + remaining - 8, fold);
+    }
+
+    uint64_t high, low;
+    ltbs_mul128(a ^ secret[1], b ^ seed, &high, &low);
+
+    return wyhash_mix(low ^ secret[0] ^ length, high ^ secret[1]);
+}
+
+uint64_t hash_bytes(const void *bytes, size_t length, uint64_t seed)
+{
+    return wyhash(bytes, length, seed, 0);
+}
+
+uint64_t hash_compute(ltbs_string *key)
+{
+    return wyhash(key->strdata, key->length, LTBS_HASH_SEED, 0);
+}
+
+// Equal to hash_compute() of the upcased key, without making the copy.
+uint64_t hash_compute_nocase(ltbs_string *key)
+{
+    return wyhash(key->strdata, key->length, LTBS_HASH_SEED, 1);
+}
+
+// One folded 64x64->128 multiply of the seeded value, as wyhash
+// finishes, so both the trie's top bits and the flat map's low bits
+// depend on every input bit.
+uint64_t hash_mix64(uint64_t value)
+{
+    return wyhash_mix(value ^ WYHASH_SECRET[0], LTBS_HASH_SEED ^ WYHASH_SECRET[1]);
+}
+
+// Interned and pre-hashed keys already carry their hash.
+static uint64_t hash_key(ltbs_cell *key)
+{
+    if ( key->data.string.flags & LTBS_STRING_HASHED )
+	return key->data.string.hash;
+
+    return hash_compute(&key->data.string);
+}
+
+// Whether a stored key is the one with these bytes and `hash`. Its own
+// hash only counts when HASHED says it was set.
+static int hash_key_matches(ltbs_cell *stored, const byte *bytes, size_t length, uint64_t hash)
+{
+    return (stored->data.string.length == length) &&
+	(!(stored->data.string.flags & LTBS_STRING_HASHED) || (stored->data.string.hash == hash)) &&
+	((stored->data.string.strdata == bytes) ||
+	 (memcmp(stored->data.string.strdata, bytes, length) == 0));
+}
+
+// Walks the trie along `hash` and returns the slot holding the key with
+// the given bytes, or the empty slot where that key belongs. Stored keys
+// carry their hash, so most mismatches are settled without a memcmp.
+static ltbs_cell **hash_find_slot(ltbs_cell **map, const byte *bytes, size_t length, uint64_t hash)
+{
+    const uint64_t full_hash = hash;
+
+    for ( ; *map; hash <<= 2 )
+    {
+	ltbs_cell *current = (*map)->data.hashmap.key;
+
+	if ( (current != 0) && hash_key_matches(current, bytes, length, full_hash) )
+	    return map;
+
+	map = &(*map)->data.hashmap.children[hash >> 62];
+    }
+
+    return map;
+}
+
+#define FLAT_GROUP 16
+#define FLAT_EMPTY ((int8_t) -128)
+#define FLAT_DELETED ((int8_t) -2)
+#define flat_tag(hash) ((int8_t) ((hash) & 0x7F))
+
+// Bit i is set when control byte i of the group equals `value`.
+static unsigned int flat_match(const int8_t *group, int8_t value)
+{
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    __m128i bytes = _mm_loadu_si128((const __m128i *) group);
+    return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value)));
+#else
+    unsigned int result = 0;
+
+    for ( unsigned int index = 0; index < FLAT_GROUP; index++ )
+	if ( group[index] == value ) result |= 1u << index;
+
+    return result;
+#endif
+}
+
+// EMPTY and DELETED are the only negative control bytes.
+static unsigned int flat_match_free(const int8_t *group)
+{
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    return (unsigned int) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+    unsigned int result = 0;
+
+    for ( unsigned int index = 0; index < FLAT_GROUP; index++ )
+	if ( group[index] < 0 ) result |= 1u << index;
+
+    return result;
+#endif
+}
+
+// Smallest power of two, at least one group, that holds `count` entries
+// at no more than 7/8 load.
+static size_t flat_capacity_for(size_t count)
+{
+    size_t capacity = FLAT_GROUP;
+
+    while ( count * 8 > capacity * 7 )
+	capacity *= 2;
+
+    return capacity;
+}
+
+static void flat_set_control(ltbs_flatmap *map, size_t index, int8_t value)
+{
+    map->control[index] = value;
+
+    if ( index < FLAT_GROUP )
+	map->control[map->capacity + index] = value;
+}
+
+static void flat_alloc_tables(ltbs_flatmap *map, size_t capacity, Arena *context)
+{
+    map->capacity = capacity;
+    map->control = arena_alloc(context, capacity + FLAT_GROUP);
+    map->slots = arena_alloc(context, capacity * sizeof(ltbs_flat_slot));
+    memset(map->control, FLAT_EMPTY, capacity + FLAT_GROUP);
+}
+
+// Groups are probed at triangular offsets, which visits every group of
+// a power of two table before repeating one.
+static ltbs_flat_slot *flat_find(ltbs_flatmap *map, const byte *bytes, size_t length, uint64_t hash)
+{
+    size_t mask = map->capacity - 1;
+    size_t position = (size_t) (hash >> 7) & mask;
+
+    for ( size_t step = FLAT_GROUP; ; step += FLAT_GROUP )
+    {
+	const int8_t *group = &map->control[position];
+
+	for ( unsigned int matches = flat_match(group, flat_tag(hash)); matches; matches &= matches - 1 )
+	{
+	    ltbs_flat_slot *slot = &map->slots[(position + (size_t) __builtin_ctz(matches)) & mask];
+	    ltbs_cell *key = slot->key;
+
+	    if ( (key->data.string.hash == hash) &&
+		 (key->data.string.length == length) &&
+		 (memcmp(key->data.string.strdata, bytes, length) == 0) )
+		return slot;
+	}
+
+	if ( flat_match(group, FLAT_EMPTY) )
+	    return 0;
+
+	position = (position + step) & mask;
+    }
+}
+
+static size_t flat_find_free(ltbs_flatmap *map, uint64_t hash)
+{
+    size_t mask = map->capacity - 1;
+    size_t position = (size_t) (hash >> 7) & mask;
+
+    for ( size_t step = FLAT_GROUP; ; step += FLAT_GROUP )
+    {
+	unsigned int free_slots = flat_match_free(&map->control[position]);
+
+	if ( free_slots )
+	    return (position + (size_t) __builtin_ctz(free_slots)) & mask;
+
+	position = (position + step) & mask;
+    }
+}
+
+// Moves every entry into fresh tables of `capacity` slots from the
+// arena, dropping the DELETED markers. Stored keys are always HASHED.
+static void flat_rehash(ltbs_flatmap *map, size_t capacity, Arena *context)
+{
+    int8_t *old_control = map->control;
+    ltbs_flat_slot *old_slots = map->slots;
+    size_t old_capacity = map->capacity;
+
+    flat_alloc_tables(map, capacity, context);
+    map->deleted = 0;
+
+    for ( size_t index = 0; index < old_capacity; index++ )
+    {
+	if ( old_control[index] < 0 )
+	    continue;
+
+	uint64_t hash = old_slots[index].key->data.string.hash;
+	size_t target = flat_find_free(map, hash);
+
+	flat_set_control(map, target, flat_tag(hash));
+	map->slots[target] = old_slots[index];
+    }
+}
+
+ltbs_cell *flat_make(size_t capacity, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context);
+    ltbs_flatmap *map = arena_alloc(context, sizeof(ltbs_flatmap));
+
+    *map = (ltbs_flatmap) {0};
+    flat_alloc_tables(map, flat_capacity_for(capacity), context);
+
+    result->type = LTBS_FLATMAP;
+    result->data.flatmap = map;
+
+    return result;
+}
+
+void flat_reserve(ltbs_cell **map, size_t count, Arena *context)
+{
+    ltbs_flatmap *flat = (*map)->data.flatmap;
+
+    if ( (count + flat->deleted) * 8 > flat->capacity * 7 )
+	flat_rehash(flat, flat_capacity_for(count), context);
+}
+
+// The key a map stores for `bytes`: `adopted` itself when given, else
+// a fresh copy. Either way it carries the hash it was filed under, and
+// `flags` on top.
+static ltbs_cell *hash_stored_key(const byte *bytes, size_t length, uint64_t hash, ltbs_cell *adopted,
+				  int flags, Arena *context)
+{
+    ltbs_cell *result = adopted;
+
+    if ( result == 0 )
+    {
+	result = string_alloc(length, context);
+	memcpy(result->data.string.strdata, bytes, length);
+    }
+
+    result->data.string.hash = hash;
+    result->data.string.flags |= LTBS_STRING_HASHED | flags;
+
+    return result;
+}
+
+static ltbs_cell *flat_insert(ltbs_flatmap *map, const byte *bytes, size_t length, uint64_t hash,
+			      ltbs_cell *adopted, int flags, ltbs_cell *value, Arena *context)
+{
+    ltbs_flat_slot *slot = flat_find(map, bytes, length, hash);
+
+    if ( slot != 0 )
+    {
+	if ( (context != 0) && (value != 0) )
+	    slot->value = value;
+
+	return slot->value;
+    }
+
+    if ( (context == 0) || (value == 0) )
+	return 0;
+
+    // Doubling when full, but rehashing in place when mostly DELETED.
+    if ( (map->count + map->deleted + 1) * 8 > map->capacity * 7 )
+	flat_rehash(map, flat_capacity_for(2 * (map->count + 1)), context);
+
+    size_t index = flat_find_free(map, hash);
+    ltbs_cell *stored = hash_stored_key(bytes, length, hash, adopted, flags, context);
+
+    if ( map->control[index] == FLAT_DELETED )
+	map->deleted--;
+
+    flat_set_control(map, index, flat_tag(hash));
+    map->slots[index] = (ltbs_flat_slot) { .key = stored, .value = value };
+    map->count++;
+
+    return value;
+}
+
+static ltbs_cell *flat_remove(ltbs_flatmap *map, const byte *bytes, size_t length, uint64_t hash)
+{
+    ltbs_flat_slot *slot = flat_find(map, bytes, length, hash);
+
+    if ( slot == 0 )
+	return 0;
+
+    flat_set_control(map, (size_t) (slot - map->slots), FLAT_DELETED);
+    map->count--;
+    map->deleted++;
+
+    return slot->value;
+}
+
+// Every insertion ends here, whatever the key type or engine. `hash`
+// must be the one the map files these bytes under; `flags` are added
+// to a newly stored key.
+static ltbs_cell *hash_insert(ltbs_cell **map, const byte *bytes, size_t length, uint64_t hash,
+			      ltbs_cell *adopted, int flags, ltbs_cell *value, Arena *context)
+{
+    // A null map is an empty trie until its first entry gives it a root.
+    if ( *map == 0 )
+    {
+	if ( (context == 0) || (value == 0) )
+	    return 0;
+
+	*map = hash_make(context);
+    }
+
+    if ( (*map)->type == LTBS_FLATMAP )
+	return flat_insert((*map)->data.flatmap, bytes, length, hash, adopted, flags, value, context);
+
+    ltbs_cell *result = 0;
+    ltbs_cell **slot = hash_find_slot(map, bytes, length, hash);
+
+    if ( *slot != 0 )
+    {
+	if ( (context != 0) && (value != 0) )
+	{
+	    (*slot)->data.hashmap.value = value;
+	    return value;
+	}
+
+	return (*slot)->data.hashmap.value;
+    }
+
+    if ( (context != 0) && (value != 0) )
+    {
+	*slot = hash_make(context);
+	(*slot)->data.hashmap.key = hash_stored_key(bytes, length, hash, adopted, flags, context);
+	(*slot)->data.hashmap.value = value;
+	(*map)->data.hashmap.count++;
+
+	result = value;
+    }
+    
+    return result;
+}
+
+ltbs_cell *hash_upsert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+{
+    return hash_insert(
+	map,
+	key->data.string.strdata,
+	key->data.string.length,
+	hash_key(key),
+	0, 0, value, context
+    );
+}
+
+// Like hash_upsert() but stores `key` itself instead of a copy, so the
+// key must live as long as the map and must not change afterwards.
+ltbs_cell *hash_adopt(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+{
+    return hash_insert(
+	map,
+	key->data.string.strdata,
+	key->data.string.length,
+	hash_key(key),
+	key, 0, value, context
+    );
+}
+
+// `hash` must be Hash_Vt.compute() of the bytes.
+ltbs_cell *hash_lookup_hashed(ltbs_cell **map, const byte *bytes, size_t length, uint64_t hash)
+{
+    if ( *map == 0 )
+	return 0;
+
+    if ( (*map)->type == LTBS_FLATMAP )
+    {
+	ltbs_flat_slot *found = flat_find((*map)->data.flatmap, bytes, length, hash);
+	return found ? found->value : 0;
+    }
+
+    ltbs_cell **slot = hash_find_slot(map, bytes, length, hash);
+
+    return *slot ? (*slot)->data.hashmap.value : 0;
+}
+
+ltbs_cell *hash_lookup_bytes(ltbs_cell **map, const byte *bytes, size_t length)
+{
+    return hash_lookup_hashed(map, bytes, length, hash_bytes(bytes, length, LTBS_HASH_SEED));
+}
+
+ltbs_cell *hash_lookup_view(ltbs_cell **map, ltbs_cell *key)
+{
+    return hash_lookup_hashed(map, key->data.string.strdata, key->data.string.length, hash_key(key));
+}
+
+ltbs_cell *hash_lookup(ltbs_cell **map, byte *cstring)
+{
+    return hash_lookup_bytes(map, cstring, strlen(cstring));
+}
+
+// Any key below a node also belongs on the path through it, so removal
+// moves some leaf's entry into the emptied node and unlinks the leaf
+// instead. Nothing is left behind for later lookups to step over. The
+// unlinked cell stays in the arena that allocated it.
+static ltbs_cell *hash_remove_hashed(ltbs_cell **map, const byte *bytes, size_t length, uint64_t hash)
+{
+    if ( *map == 0 )
+	return 0;
+
+    if ( (*map)->type == LTBS_FLATMAP )
+	return flat_remove((*map)->data.flatmap, bytes, length, hash);
+
+    ltbs_cell **slot = hash_find_slot(map, bytes, length, hash);
+
+    if ( *slot == 0 )
+	return 0;
+
+    ltbs_cell *node = *slot;
+    ltbs_cell *result = node->data.hashmap.value;
+    ltbs_cell **leaf = slot;
+
+    for ( int index = 0; index < 4; )
+    {
+	if ( (*leaf)->data.hashmap.children[index] != 0 )
+	{
+	    leaf = &(*leaf)->data.hashmap.children[index];
+	    index = 0;
+	}
+
+	else index++;
+    }
+
+    node->data.hashmap.key = (*leaf)->data.hashmap.key;
+    node->data.hashmap.value = (*leaf)->data.hashmap.value;
+    *leaf = 0;
+    (*map)->data.hashmap.count--;
+
+    return result;
+}
+
+ltbs_cell *hash_remove(ltbs_cell **map, ltbs_cell *key)
+{
+    return hash_remove_hashed(map, key->data.string.strdata, key->data.string.length, hash_key(key));
+}
+
+// Byte keys, such as structs or UUIDs, hash like strings of the same
+// bytes, so lookup_bytes() finds them too.
+ltbs_cell *hash_upsert_bytes(ltbs_cell **map, const void *key, size_t size, ltbs_cell *value, Arena *context)
+{
+    return hash_insert(map, key, size, hash_bytes(key, size, LTBS_HASH_SEED), 0, 0, value, context);
+}
+
+ltbs_cell *hash_remove_bytes(ltbs_cell **map, const void *key, size_t size)
+{
+    return hash_remove_hashed(map, key, size, hash_bytes(key, size, LTBS_HASH_SEED));
+}
+
+// Integer keys are stored as their 8 native-order bytes, filed under
+// hash_mix64() of the value instead of a string hash. A map should use
+// either these or the string and byte functions, not both. An int64 key
+// and the uint64 with the same bits are the same key; the stored key is
+// flagged INT_KEY or UINT_KEY after the function that first added it,
+// which decides how the JSON writer and templates print it.
+ltbs_cell *hash_upsert_uint(ltbs_cell **map, uint64_t key, ltbs_cell *value, Arena *context)
+{
+    return hash_insert(map, (const byte *) &key, sizeof(key), hash_mix64(key), 0, LTBS_STRING_UINT_KEY, value, context);
+}
+
+ltbs_cell *hash_lookup_uint(ltbs_cell **map, uint64_t key)
+{
+    return hash_lookup_hashed(map, (const byte *) &key, sizeof(key), hash_mix64(key));
+}
+
+ltbs_cell *hash_remove_uint(ltbs_cell **map, uint64_t key)
+{
+    return hash_remove_hashed(map, (const byte *) &key, sizeof(key), hash_mix64(key));
+}
+
+ltbs_cell *hash_upsert_int(ltbs_cell **map, int64_t key, ltbs_cell *value, Arena *context)
+{
+    uint64_t bits = (uint64_t) key;
+
+    return hash_insert(map, (const byte *) &bits, sizeof(bits), hash_mix64(bits), 0, LTBS_STRING_INT_KEY, value, context);
+}
+
+ltbs_cell *hash_lookup_int(ltbs_cell **map, int64_t key)
+{
+    return hash_lookup_uint(map, (uint64_t) key);
+}
+
+ltbs_cell *hash_remove_int(ltbs_cell **map, int64_t key)
+{
+    return hash_remove_uint(map, (uint64_t) key);
+}
+
+// Reads back a key stored by the integer functions, as listed by keys().
+uint64_t hash_key_uint(ltbs_cell *key)
+{
+    uint64_t result;
+    memcpy(&result, key->data.string.strdata, sizeof(result));
+
+    return result;
+}
+
+int64_t hash_key_int(ltbs_cell *key)
+{
+    return (int64_t) hash_key_uint(key);
+}
+
+size_t hash_count(ltbs_cell **map)
+{
+    if ( *map == 0 )
+	return 0;
+
+    if ( (*map)->type == LTBS_FLATMAP )
+	return (*map)->data.flatmap->count;
+
+    return (*map)->data.hashmap.count;
+}
+
+// Drops every entry but keeps the root, so pointers to the map stay
+// valid.
+void hash_clear(ltbs_cell **map)
+{
+    if ( *map == 0 )
+	return;
+
+    if ( (*map)->type == LTBS_FLATMAP )
+    {
+	ltbs_flatmap *flat = (*map)->data.flatmap;
+
+	memset(flat->control, FLAT_EMPTY, flat->capacity + FLAT_GROUP);
+	flat->count = 0;
+	flat->deleted = 0;
+	return;
+    }
+
+    for ( int index = 0; index < 4; index++ )
+	(*map)->data.hashmap.children[index] = 0;
+
+    (*map)->data.hashmap.count = 0;
+}
+
+ltbs_hash_iter hash_iter(ltbs_cell **map)
+{
+    ltbs_hash_iter result;
+
+    result.map = *map;
+    result.index = 0;
+    result.top = *map != 0;
+    result.stack[0] = *map;
+
+    return result;
+}
+
+// Fills whichever of `key` and `value` are given with the next entry and
+// returns 1, or returns 0 once the map is exhausted. Trie entries come in
+// preorder, first child first; the map must not change meanwhile.
+int hash_next(ltbs_hash_iter *iter, ltbs_cell **key, ltbs_cell **value)
+{
+    ltbs_flat_slot *found = 0;
+    ltbs_cell *node = 0;
+
+    if ( iter->map == 0 )
+	return 0;
+
+    if ( iter->map->type == LTBS_FLATMAP )
+    {
+	ltbs_flatmap *flat = iter->map->data.flatmap;
+
+	for ( ; (found == 0) && (iter->index < flat->capacity); iter->index++ )
+	    if ( flat->control[iter->index] >= 0 )
+		found = &flat->slots[iter->index];
+
+	if ( found == 0 )
+	    return 0;
+
+	if ( key ) *key = found->key;
+	if ( value ) *value = found->value;
+
+	return 1;
+    }
+
+    while ( iter->top > 0 )
+    {
+	node = iter->stack[--iter->top];
+
+	for ( int child = 3; child >= 0; child-- )
+	    if ( node->data.hashmap.children[child] != 0 )
+		iter->stack[iter->top++] = node->data.hashmap.children[child];
+
+	if ( node->data.hashmap.key != 0 )
+	{
+	    if ( key ) *key = node->data.hashmap.key;
+	    if ( value ) *value = node->data.hashmap.value;
+
+	    return 1;
+	}
+    }
+
+    return 0;
+}
+
+ltbs_cell *hash_keys(ltbs_cell **map, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
+    ltbs_hash_iter iter = hash_iter(map);
+    ltbs_cell *key;
+
+    while ( hash_next(&iter, &key, 0) )
+	result = pair_cons(key, result, context);
+
+    return result;
+}
+
+ltbs_cell *hash_values(ltbs_cell **map, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
+    ltbs_hash_iter iter = hash_iter(map);
+    ltbs_cell *value;
+
+    while ( hash_next(&iter, 0, &value) )
+	result = pair_cons(value, result, context);
+
+    return result;
+}
+
+// Each entry is a pair of the key and its value.
+ltbs_cell *hash_entries(ltbs_cell **map, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
+    ltbs_hash_iter iter = hash_iter(map);
+    ltbs_cell *key;
+    ltbs_cell *value;
+
+    while ( hash_next(&iter, &key, &value) )
+	result = pair_cons(pair_cons(key, value, context), result, context);
+
+    return result;
+}
+
+void hash_for_each(ltbs_cell **map, entry_fn callback, void *param)
+{
+    ltbs_hash_iter iter = hash_iter(map);
+    ltbs_cell *key;
+    ltbs_cell *value;
+
+    while ( hash_next(&iter, &key, &value) )
+	callback(key, value, param);
+}
+
+// Returns the node holding `key`, inserting one with `value` when it is
+// absent and `context` is given. Keys are written before the release
+// CAS that publishes their node, so an acquire load sees them whole.
+static ltbs_cell *concurrent_find(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+{
+    const byte *bytes = key->data.string.strdata;
+    size_t length = key->data.string.length;
+    uint64_t hash = hash_key(key);
+    ltbs_cell *fresh = 0;
+    ltbs_cell **slot = &(*map)->data.hashmap.children[hash >> 62];
+
+    for ( uint64_t walk = hash << 2; ; walk <<= 2 )
+    {
+	ltbs_cell *node = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+	if ( node == 0 )
+	{
+	    if ( (context == 0) || (value == 0) )
+		return 0;
+
+	    if ( fresh == 0 )
+	    {
+		fresh = hash_make(context);
+		fresh->data.hashmap.key = hash_stored_key(bytes, length, hash, 0, 0, context);
+		fresh->data.hashmap.value = value;
+	    }
+
+	    if ( __atomic_compare_exchange_n(slot, &node, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+	    {
+		__atomic_fetch_add(&(*map)->data.hashmap.count, 1, __ATOMIC_RELAXED);
+		return fresh;
+	    }
+
+	    // Lost the race; `node` now holds the winner, which may
+	    // still be this key.
+	}
+
+	if ( hash_key_matches(node->data.hashmap.key, bytes, length, hash) )
+	    return node;
+
+	slot = &node->data.hashmap.children[walk >> 62];
+    }
+}
+
+// Inserts `key` or atomically replaces its value. Without a value or
+// context it is a lookup, like hash_upsert().
+ltbs_cell *concurrent_upsert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+{
+    ltbs_cell *node = concurrent_find(map, key, value, context);
+
+    if ( node == 0 )
+	return 0;
+
+    if ( (context != 0) && (value != 0) )
+    {
+	__atomic_store_n(&node->data.hashmap.value, value, __ATOMIC_RELEASE);
+	return value;
+    }
+
+    return __atomic_load_n(&node->data.hashmap.value, __ATOMIC_ACQUIRE);
+}
+
+// Inserts `key` only when absent and returns the value the map ends up
+// holding, so racing threads all agree on the first one stored.
+ltbs_cell *concurrent_insert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+{
+    ltbs_cell *node = concurrent_find(map, key, value, context);
+
+    return node ? __atomic_load_n(&node->data.hashmap.value, __ATOMIC_ACQUIRE) : 0;
+}
+
+ltbs_cell *concurrent_lookup(ltbs_cell **map, ltbs_cell *key)
+{
+    return concurrent_upsert(map, key, 0, 0);
+}
+
+// Swaps in `desired` only while the value is still `expected`. Returns 0
+// when the key is absent or another thread changed the value first.
+int concurrent_replace(ltbs_cell **map, ltbs_cell *key, ltbs_cell *expected, ltbs_cell *desired)
+{
+    ltbs_cell *node = concurrent_find(map, key, 0, 0);
+
+    return (node != 0) &&
+	__atomic_compare_exchange_n(
+	    &node->data.hashmap.value, &expected, desired,
+	    0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+	);
+}
+
+static ltbs_cell *persistent_copy(ltbs_cell *node, Arena *context)
+{
+    ltbs_cell *result = ltbs_alloc(context);
+    *result = *node;
+
+    return result;
+}
+
+// Copies the root and every node down to the one holding the key, or to
+// the empty slot where it belongs, and returns that slot in the copy.
+static ltbs_cell **persistent_path(ltbs_cell **root, const byte *bytes, size_t length, uint64_t hash, Arena *context)
+{
+    *root = persistent_copy(*root, context);
+    ltbs_cell **slot = &(*root)->data.hashmap.children[hash >> 62];
+
+    for ( uint64_t walk = hash << 2; *slot != 0; walk <<= 2 )
+    {
+	ltbs_cell *current = (*slot)->data.hashmap.key;
+	*slot = persistent_copy(*slot, context);
+
+	if ( hash_key_matches(current, bytes, length, hash) )
+	    break;
+
+	slot = &(*slot)->data.hashmap.children[walk >> 62];
+    }
+
+    return slot;
+}
+
+// Flat maps keep their entries in one table, which would be copied
+// whole on every update.
+static int persistent_refuses(ltbs_cell *map)
+{
+    if ( (map == 0) || (map->type != LTBS_FLATMAP) )
+	return 0;
+
+    fprintf(stderr, "Persistent_Vt: flat maps are not supported\n");
+    return 1;
+}
+
+ltbs_cell *persistent_upsert(ltbs_cell *map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+{
+    const byte *bytes = key->data.string.strdata;
+    size_t length = key->data.string.length;
+    uint64_t hash = hash_key(key);
+
+    if ( persistent_refuses(map) )
+	return 0;
+
+    if ( hash_lookup_hashed(&map, bytes, length, hash) == value )
+	return map;
+
+    // The first entry gives a null map its root; the copy below is then
+    // one node more than needed.
+    ltbs_cell *result = map != 0 ? map : hash_make(context);
+    ltbs_cell **slot = persistent_path(&result, bytes, length, hash, context);
+
+    if ( *slot == 0 )
+    {
+	*slot = hash_make(context);
+	(*slot)->data.hashmap.key = hash_stored_key(bytes, length, hash, 0, 0, context);
+	result->data.hashmap.count++;
+    }
+
+    (*slot)->data.hashmap.value = value;
+
+    return result;
+}
+
+// The leaf swap of hash_remove(), copying the nodes between the removed
+// entry and the leaf as well, since the leaf's parent changes.
+ltbs_cell *persistent_remove(ltbs_cell *map, ltbs_cell *key, Arena *context)
+{
+    const byte *bytes = key->data.string.strdata;
+    size_t length = key->data.string.length;
+    uint64_t hash = hash_key(key);
+
+    if ( persistent_refuses(map) )
+	return 0;
+
+    if ( hash_lookup_hashed(&map, bytes, length, hash) == 0 )
+	return map;
+
+    ltbs_cell *result = map;
+    ltbs_cell **slot = persistent_path(&result, bytes, length, hash, context);
+    ltbs_cell *node = *slot;
+    ltbs_cell **leaf = slot;
+
+    for ( int index = 0; index < 4; )
+    {
+	ltbs_cell **child = &(*leaf)->data.hashmap.children[index];
+
+	if ( *child == 0 )
+	{
+	    index++;
+	    continue;
+	}
+
+	ltbs_cell **grandchildren = (*child)->data.hashmap.children;
+
+	if ( grandchildren[0] || grandchildren[1] || grandchildren[2] || grandchildren[3] )
+	    *child = persistent_copy(*child, context);
+
+	leaf = child;
+	index = 0;
+    }
+
+    node->data.hashmap.key = (*leaf)->data.hashmap.key;
+    node->data.hashmap.value = (*leaf)->data.hashmap.value;
+    *leaf = 0;
+    result->data.hashmap.count--;
+
+    return result;
+}
+
+ltbs_intern_table *intern_new(Arena *context)
+{
+    ltbs_intern_table *result = arena_alloc(context, sizeof(ltbs_intern_table));
+
+    result->map = hash_make(context);
+    result->context = context;
+    result->count = 0;
+
+    return result;
+}
+
+// Returns the canonical string for these bytes, copying them into the
+// table's arena the first time they are seen. The canonical string is
+// its own value in the underlying trie.
+ltbs_cell *intern_bytes(ltbs_intern_table *table, const byte *bytes, size_t length)
+{
+    ltbs_string view = { .strdata = (byte *) bytes, .length = (unsigned int) length };
+    uint64_t hash = hash_compute(&view);
+    ltbs_cell **slot = hash_find_slot(&table->map, bytes, length, hash);
+
+    if ( *slot != 0 )
+	return (*slot)->data.hashmap.key;
+
+    ltbs_cell *canonical = string_alloc(length, table->context);
+
+    memcpy(canonical->data.string.strdata, bytes, length);
+    canonical->data.string.flags |= LTBS_STRING_INTERNED | LTBS_STRING_HASHED;
+    canonical->data.string.hash = hash;
+
+    *slot = hash_make(table->context);
+    (*slot)->data.hashmap.key = canonical;
+    (*slot)->data.hashmap.value = canonical;
+    table->map->data.hashmap.count++;
+    table->count++;
+
+    return canonical;
+}
+
+ltbs_cell *intern_string(ltbs_intern_table *table, ltbs_cell *string)
+{
+    return intern_bytes(table, string->data.string.strdata, string->data.string.length);
+}
+
+ltbs_cell *intern_cstring(ltbs_intern_table *table, const char *cstring)
+{
+    return intern_bytes(table, (const byte *) cstring, strlen(cstring));
+}
+
+size_t intern_count(ltbs_intern_table *table)
+{
+    return table->count;
+}
+
+// Splits `format` into text runs and {{key}} placeholders. Spaces
+// around a key are ignored; an unterminated or empty {{}} is kept as
+// text. The template copies `format`, so it may be a temporary.
+ltbs_template *template_compile(const char *format, Arena *context)
+{
+    size_t length = strlen(format);
+    byte *source = arena_alloc(context, length + 1);
+    size_t capacity = 1;
+
+    memcpy(source, format, length + 1);
+
+    for ( const char *cursor = strstr(format, "{{"); cursor; cursor = strstr(cursor + 2, "{{") )
+	capacity++;
+
+    ltbs_template *result = arena_alloc(context, sizeof(ltbs_template));
+    result->segments = arena_alloc(context, sizeof(ltbs_template_segment) * capacity);
+    result->count = 0;
+    result->literal_length = 0;
+
+    byte *text_start = source;
+    byte *cursor = source;
+    byte *end = source + length;
+
+    while ( (cursor = (byte *) strstr((char *) cursor, "{{")) != 0 )
+    {
+	byte *key_start = cursor + 2;
+	byte *close = (byte *) strstr((char *) key_start, "}}");
+
+	if ( close == 0 )
+	    break;
+
+	byte *key_end = close;
+
+	while ( (key_start < key_end) && (*key_start == ' ') ) key_start++;
+	while ( (key_end > key_start) && (key_end[-1] == ' ') ) key_end--;
+
+	if ( key_start == key_end )
+	{
+	    cursor = close + 2;
+	    continue;
+	}
+
+	ltbs_template_segment *segment = &result->segments[result->count++];
+	ltbs_cell *key = ltbs_alloc(context);
+
+	key->type = LTBS_STRING;
+	key->data.string.strdata = key_start;
+	key->data.string.length = (unsigned int) (key_end - key_start);
+	key->data.string.hash = hash_compute(&key->data.string);
+	key->data.string.flags = LTBS_STRING_HASHED;
+
+	segment->text = (ltbs_cell) {0};
+	segment->text.type = LTBS_STRING;
+	segment->text.data.string.strdata = text_start;
+	segment->text.data.string.length = (unsigned int) (cursor - text_start);
+	segment->key = key;
+	result->literal_length += segment->text.data.string.length;
+
+	text_start = cursor = close + 2;
+    }
+
+    ltbs_template_segment *last = &result->segments[result->count++];
+
+    last->text = (ltbs_cell) {0};
+    last->text.type = LTBS_STRING;
+    last->text.data.string.strdata = text_start;
+    last->text.data.string.length = (unsigned int) (end - text_start);
+    last->key = 0;
+    result->literal_length += last->text.data.string.length;
+
+    return result;
+}
+
+static void template_append_hashmap(ltbs_string_builder *builder, ltbs_cell *map)
+{
+    ltbs_hash_iter iter = hash_iter(&map);
+    ltbs_cell *key;
+    ltbs_cell *value;
+    int first = 1;
+
+    builder_append_byte(builder, '{');
+
+    while ( hash_next(&iter, &key, &value) )
+    {
+	if ( !first )
+	    builder_append_bytes(builder, (const byte *) ", ", 2);
+
+	first = 0;
+
+	if ( key->data.string.flags & LTBS_STRING_INT_KEY )
+	    builder_append_int(builder, hash_key_int(key));
+
+	else if ( key->data.string.flags & LTBS_STRING_UINT_KEY )
+	    builder_append_uint(builder, hash_key_uint(key));
+
+	else builder_append_cell(builder, key);
+
+	builder_append_bytes(builder, (const byte *) ": ", 2);
+	template_append_value(builder, value);
+    }
+
+    builder_append_byte(builder, '}');
+}
+
+// Writes any cell as text: scalars and strings as builder_append_cell()
+// does, lists as (a b c), arrays of cells as [a, b, c], hashmaps as
+// {key: value, ...} with integer keys as numbers, and custom cells as
+// <custom size=N>.
+void template_append_value(ltbs_string_builder *builder, ltbs_cell *value)
+{
+    if ( value == 0 )
+	return;
+
+    switch ( value->type )
+    {
+	case LTBS_PAIR:
+	{
+	    int first = 1;
+
+	    builder_append_byte(builder, '(');
+	    pair_iterate(value, head, tracker,
+	    {
+		if ( !first )
+		    builder_append_byte(builder, ' ');
+
+		first = 0;
+		template_append_value(builder, head);
+	    });
+	    builder_append_byte(builder, ')');
+	}
+	break;
+
+	case LTBS_ARRAY:
+	{
+	    size_t elem_size = value->data.array.elem_size;
+	    size_t length = elem_size != 0 ? value->data.array.total_size / elem_size : 0;
+
+	    if ( elem_size != sizeof(ltbs_cell) )
+	    {
+		builder_append_format(builder, "<array elem_size=%zu length=%zu>", elem_size, length);
+		break;
+	    }
+
+	    ltbs_cell *elements = value->data.array.buffer;
+
+	    builder_append_byte(builder, '[');
+
+	    for ( size_t index = 0; index < length; index++ )
+	    {
+		if ( index > 0 )
+		    builder_append_bytes(builder, (const byte *) ", ", 2);
+
+		template_append_value(builder, &elements[index]);
+	    }
+
+	    builder_append_byte(builder, ']');
+	}
+	break;
+
+	case LTBS_HASHMAP:
+	case LTBS_FLATMAP:
+	    template_append_hashmap(builder, value);
+	    break;
+
+	case LTBS_CUSTOM:
+	    builder_append_format(builder, "<custom size=%zu>", value->data.custom.size);
+	    break;
+
+	default:
+	    builder_append_cell(builder, value);
+	    break;
+    }
+}
+
+// Placeholders whose key is missing from `data_map` render as nothing.
+void template_render_into(ltbs_template *compiled, ltbs_cell *data_map, ltbs_string_builder *builder)
+{
+    for ( size_t index = 0; index < compiled->count; index++ )
+    {
+	ltbs_template_segment *segment = &compiled->segments[index];
+
+	builder_append_bytes(
+	    builder,
+	    segment->text.data.string.strdata,
+	    segment->text.data.string.length
+	);
+
+	if ( segment->key != 0 )
+	    template_append_value(builder, hash_upsert(&data_map, segment->key, 0, 0));
+    }
+}
+
+ltbs_cell *template_render(ltbs_template *compiled, ltbs_cell *data_map, Arena *context)
+{
+    ltbs_string_builder builder = builder_new(compiled->literal_length + 16 * compiled->count, context);
+
+    template_render_into(compiled, data_map, &builder);
+    return builder_finish(&builder);
+}
+
+ltbs_template_cache *template_cache_new(Arena *context)
+{
+    ltbs_template_cache *result = arena_alloc(context, sizeof(ltbs_template_cache));
+
+    result->map = hash_make(context);
+    result->context = context;
+
+    return result;
+}
+
+// Returns the compiled form of `format`, compiling it into the cache's
+// arena on first use. Callers that keep the returned template skip even
+// the hash of the source text on later renders.
+ltbs_template *template_cache_get(ltbs_template_cache *cache, const char *format)
+{
+    ltbs_cell key = {0};
+
+    key.type = LTBS_STRING;
+    key.data.string.strdata = (byte *) format;
+    key.data.string.length = (unsigned int) strlen(format);
+
+    ltbs_cell *found = hash_upsert(&cache->map, &key, 0, 0);
+
+    if ( found != 0 )
+	return found->data.custom.data;
+
+    ltbs_cell *entry = ltbs_alloc(cache->context);
+
+    entry->type = LTBS_CUSTOM;
+    entry->data.custom.data = template_compile(format, cache->context);
+    entry->data.custom.size = sizeof(ltbs_template);
+    hash_upsert(&cache->map, &key, entry, cache->context);
+
+    return entry->data.custom.data;
+}
+
+// One-shot compile and render of a {{key}} template against a hashmap.
+ltbs_cell *format_string(char *format, ltbs_cell *data_list, Arena *context)
+{
+    return template_render(template_compile(format, context), data_list, context);
+}
+
+// Encodes one code point, returning the number of bytes written (1-4).
+static size_t utf8_encode(byte *out, uint32_t codepoint)
+{
+    if ( codepoint < 0x80 )
+    {
+	out[0] = (byte) codepoint;
+	return 1;
+    }
+
+    if ( codepoint < 0x800 )
+    {
+	out[0] = (byte) (0xC0 | (codepoint >> 6));
+	out[1] = (byte) (0x80 | (codepoint & 0x3F));
+	return 2;
+    }
+
+    if ( codepoint < 0x10000 )
+    {
+	out[0] = (byte) (0xE0 | (codepoint >> 12));
+	out[1] = (byte) (0x80 | ((codepoint >> 6) & 0x3F));
+	out[2] = (byte) (0x80 | (codepoint & 0x3F));
+	return 3;
+    }
+
+    out[0] = (byte) (0xF0 | (codepoint >> 18));
+    out[1] = (byte) (0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (byte) (0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (byte) (0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+static size_t utf8_encoded_length(uint32_t codepoint)
+{
+    return codepoint < 0x80 ? 1 : codepoint < 0x800 ? 2 : codepoint < 0x10000 ? 3 : 4;
+}
+
+// Decodes the well-formed sequence at `bytes`, returning its length, or
+// 0 for an invalid, overlong, surrogate or truncated sequence.
+static size_t utf8_decode(const unsigned char *bytes, size_t remaining, uint32_t *codepoint)
+{
+    unsigned char lead = bytes[0];
+
+    if ( lead < 0x80 )
+    {
+	*codepoint = lead;
+	return 1;
+    }
+
+    // Valid second-byte ranges depend on the lead byte.
+    unsigned char low = 0x80, high = 0xBF;
+    size_t length;
+
+    if ( lead < 0xC2 ) return 0;
+    else if ( lead < 0xE0 ) length = 2;
+    else if ( lead < 0xF0 )
+    {
+	length = 3;
+	if ( lead == 0xE0 ) low = 0xA0;
+	if ( lead == 0xED ) high = 0x9F;
+    }
+    else if ( lead < 0xF5 )
+    {
+	length = 4;
+	if ( lead == 0xF0 ) low = 0x90;
+	if ( lead == 0xF4 ) high = 0x8F;
+    }
+    else return 0;
+
+    if ( (remaining < length) || (bytes[1] < low) || (bytes[1] > high) )
+	return 0;
+
+    uint32_t result = lead & (0x7F >> length);
+
+    for ( size_t index = 1; index < length; index++ )
+    {
+	if ( (bytes[index] & 0xC0) != 0x80 )
+	    return 0;
+
+	result = (result << 6) | (bytes[index] & 0x3F);
+    }
+
+    *codepoint = result;
+    return length;
+}
+
+static int utf8_validate_scalar(const unsigned char *bytes, size_t length)
+{
+    size_t index = 0;
+    uint32_t ignored;
+
+    while ( index < length )
+    {
+	// Eight ASCII bytes at a time.
+	if ( index + 8 <= length )
+	{
+	    uint64_t word;
+	    memcpy(&word, &bytes[index], sizeof(word));
+
+	    if ( (word & 0x8080808080808080ULL) == 0 )
+	    {
+		index += 8;
+		continue;
+	    }
+	}
+
+	size_t step = utf8_decode(&bytes[index], length - index, &ignored);
+
+	if ( step == 0 )
+	    return 0;
+
+	index += step;
+    }
+
+    return 1;
+}
+
+#ifdef LTBS_X86_SIMD
+// Error classes of the lookup algorithm from Keiser and Lemire,
+// "Validating UTF-8 In Less Than One Instruction Per Byte" (2021). Each
+// pair of adjacent bytes is looked up by the high nibble of the first,
+// its low nibble and the high nibble of the second; a bit that survives
+// all three lookups is an error.
+#define UTF8_TOO_SHORT (1 << 0)
+#define UTF8_TOO_LONG (1 << 1)
+#define UTF8_OVERLONG_3 (1 << 2)
+#define UTF8_TOO_LARGE (1 << 3)
+#define UTF8_SURROGATE (1 << 4)
+#define UTF8_OVERLONG_2 (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4 (1 << 6)
+#define UTF8_TWO_CONTS ((char) (1 << 7))
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+__attribute__((target("ssse3")))
+static __m128i utf8_block_errors(__m128i input, __m128i previous)
+{
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+	UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+	UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+	UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+	UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+	UTF8_TOO_SHORT,
+	UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+	UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+    );
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+	UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+	UTF8_CARRY | UTF8_OVERLONG_2,
+	UTF8_CARRY,
+	UTF8_CARRY,
+	UTF8_CARRY | UTF8_TOO_LARGE,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+	UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+    );
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+	UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+	UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+	UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+	UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+	UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+	UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+	UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+    );
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, low_nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+    __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // Bytes two or three after a 3 or 4 byte lead must be continuations.
+    __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+    __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8((char) (0xE0 - 0x80)));
+    __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8((char) (0xF0 - 0x80)));
+    __m128i must_continue = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8((char) 0x80));
+
+    return _mm_xor_si128(must_continue, special_cases);
+}
+
+static int utf8_any_error(__m128i error)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF;
+}
+
+__attribute__((target("ssse3")))
+static int utf8_validate_ssse3(const unsigned char *bytes, size_t length)
+{
+    // Nonzero where a block's tail starts a sequence it cannot finish.
+    const __m128i incomplete_limits = _mm_setr_epi8(
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	(char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1)
+    );
+    __m128i previous = _mm_setzero_si128();
+    __m128i previous_incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+
+    for ( size_t index = 0; index < length; index += 16 )
+    {
+	__m128i input;
+
+	if ( length - index >= 16 )
+	    input = _mm_loadu_si128((const __m128i *) &bytes[index]);
+
+	else
+	{
+	    unsigned char padded[16] = {0};
+	    memcpy(padded, &bytes[index], length - index);
+	    input = _mm_loadu_si128((const __m128i *) padded);
+	}
+
+	// ASCII blocks only need to check the previous block finished.
+	if ( _mm_movemask_epi8(input) == 0 )
+	    error = _mm_or_si128(error, previous_incomplete);
+
+	else
+	{
+	    error = _mm_or_si128(error, utf8_block_errors(input, previous));
+	    previous_incomplete = _mm_subs_epu8(input, incomplete_limits);
+	}
+
+	previous = input;
+
+	if ( ((index & 1023) == 0) && utf8_any_error(error) )
+	    return 0;
+    }
+
+    error = _mm_or_si128(error, previous_incomplete);
+    return !utf8_any_error(error);
+}
+#endif
+
+// Nonzero when the string is well-formed UTF-8: no overlong forms,
+// surrogates, truncated sequences or code points above U+10FFFF.
+int utf8_validate(ltbs_cell *string)
+{
+    const unsigned char *bytes = (const unsigned char *) string->data.string.strdata;
+    size_t length = string->data.string.length;
+
+#ifdef LTBS_X86_SIMD
+    if ( (length >= 16) && __builtin_cpu_supports("ssse3") )
+	return utf8_validate_ssse3(bytes, length);
+#endif
+
+    return utf8_validate_scalar(bytes, length);
+}
+
+// Number of code points in a valid UTF-8 string: the bytes that are not
+// continuation bytes.
+size_t utf8_count(ltbs_cell *string)
+{
+    const byte *bytes = string->data.string.strdata;
+    size_t length = string->data.string.length;
+    size_t index = 0;
+    size_t result = 0;
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    // Continuation bytes are the signed bytes below -64 (0xC0).
+    const __m128i last_continuation = _mm_set1_epi8((char) 0xBF);
+
+    for ( ; index + 16 <= length; index += 16 )
+    {
+	__m128i block = _mm_loadu_si128((const __m128i *) &bytes[index]);
+	unsigned int leads = (unsigned int) _mm_movemask_epi8(_mm_cmpgt_epi8(block, last_continuation));
+
+	result += (size_t) __builtin_popcount(leads);
+    }
+#endif
+
+    for ( ; index < length; index++ )
+	result += (bytes[index] & 0xC0) != 0x80;
+
+    return result;
+}
+
+ltbs_utf8_iter utf8_iter(ltbs_cell *string)
+{
+    return (ltbs_utf8_iter)
+    {
+	.cursor = string->data.string.strdata,
+	.end = string->data.string.strdata + string->data.string.length
+    };
+}
+
+// Stores the next code point and returns 1, or returns 0 at the end.
+// Each byte of an invalid sequence comes out as U+FFFD.
+int utf8_next(ltbs_utf8_iter *iter, uint32_t *codepoint)
+{
+    if ( iter->cursor >= iter->end )
+	return 0;
+
+    size_t length = utf8_decode(
+	(const unsigned char *) iter->cursor,
+	(size_t) (iter->end - iter->cursor),
+	codepoint
+    );
+
+    if ( length == 0 )
+    {
+	*codepoint = 0xFFFD;
+	length = 1;
+    }
+
+    iter->cursor += length;
+    return 1;
+}
+
+// Decodes a string into an array of uint32_t code points, or returns 0
+// if it is not valid UTF-8.
+ltbs_cell *utf8_to_utf32(ltbs_cell *string, Arena *context)
+{
+    if ( !utf8_validate(string) )
+	return 0;
+
+    size_t count = utf8_count(string);
+    ltbs_cell *result = array_new(sizeof(uint32_t), count * sizeof(uint32_t), context);
+    uint32_t *codepoints = result->data.array.buffer;
+    const unsigned char *bytes = (const unsigned char *) string->data.string.strdata;
+    size_t length = string->data.string.length;
+    size_t index = 0;
+
+    result->type = LTBS_ARRAY;
+
+    for ( size_t written = 0; written < count; written++ )
+    {
+	if ( bytes[index] < 0x80 )
+	    codepoints[written] = bytes[index++];
+
+	else index += utf8_decode(&bytes[index], length - index, &codepoints[written]);
+    }
+
+    return result;
+}
+
+// Encodes an array of uint32_t code points as a UTF-8 string, or returns
+// 0 if it holds a surrogate or a value above U+10FFFF.
+ltbs_cell *utf8_from_utf32(ltbs_cell *codepoints, Arena *context)
+{
+    const uint32_t *values = codepoints->data.array.buffer;
+    size_t count = codepoints->data.array.total_size / sizeof(uint32_t);
+    size_t length = 0;
+
+    for ( size_t index = 0; index < count; index++ )
+    {
+	if ( (values[index] > 0x10FFFF) || ((values[index] >= 0xD800) && (values[index] <= 0xDFFF)) )
+	    return 0;
+
+	length += utf8_encoded_length(values[index]);
+    }
+
+    ltbs_cell *result = ltbs_alloc(context);
+    byte *buffer = arena_alloc(context, length + 1);
+    size_t written = 0;
+
+    for ( size_t index = 0; index < count; index++ )
+	written += utf8_encode(&buffer[written], values[index]);
+
+    buffer[written] = '\0';
+    result->type = LTBS_STRING;
+    result->data.string.strdata = buffer;
+    result->data.string.length = (unsigned int) written;
+
+    return result;
+}
+
+// Bytes that make up words for LTBS_MATCH_WHOLE_WORDS; the apostrophe
+// keeps contractions like "DON'T" in one word.
+#define ascii_is_word(value) (ascii_is_digit(value) || ((unsigned char) (((value) | 0x20) - 'a') < 26) || \
+			      ((value) == '_') || ((value) == '\''))
+
+// Builds the automaton in malloc()ed scratch tables, which grow with the
+// total pattern length times the byte classes, and keeps only the final
+// tables in `context`. Returns 0 when the scratch tables do not fit.
+ltbs_matcher *matcher_compile(ltbs_cell *patterns, int options, Arena *context)
+{
+    int nocase = options & LTBS_MATCH_NOCASE;
+    int whole_words = options & LTBS_MATCH_WHOLE_WORDS;
+    ltbs_matcher *matcher = arena_alloc(context, sizeof(ltbs_matcher));
+    size_t total_length = 0;
+
+    *matcher = (ltbs_matcher) {0};
+    matcher->options = options;
+    matcher->class_count = 1;
+
+    // Class 0 stands for every byte no pattern uses.
+    for ( ltbs_cell *tracker = patterns; pair_head(tracker); tracker = pair_rest(tracker) )
+    {
+	ltbs_string *pattern = &pair_head(tracker)->data.string;
+
+	for ( unsigned int index = 0; index < pattern->length; index++ )
+	{
+	    unsigned char value = (unsigned char) pattern->strdata[index];
+
+	    if ( nocase )
+		value = (unsigned char) ascii_upcase(value);
+
+	    if ( matcher->classes[value] == 0 )
+	    {
+		matcher->classes[value] = (uint16_t) matcher->class_count++;
+
+		if ( nocase && ((unsigned char) (value - 'A') < 26) )
+		    matcher->classes[value | 0x20] = matcher->classes[value];
+	    }
+	}
+
+	total_length += pattern->length;
+	matcher->pattern_count++;
+    }
+
+    uint32_t boundary = matcher->class_count;
+
+    if ( whole_words )
+	matcher->class_count++;
+
+    // Build the trie in a dense table whose empty edges are 0, since
+    // the root is nobody's child.
+    size_t stride = matcher->class_count;
+    size_t max_states = 1 + total_length * (whole_words ? 2 : 1);
+    uint32_t *table = calloc(max_states * stride, sizeof(uint32_t));
+    uint32_t *output = calloc(max_states, sizeof(uint32_t));
+    uint32_t *fail = calloc(max_states, sizeof(uint32_t));
+    uint32_t *queue = malloc(max_states * sizeof(uint32_t));
+
+    if ( (table == 0) || (output == 0) || (fail == 0) || (queue == 0) )
+    {
+	free(table);
+	free(output);
+	free(fail);
+	free(queue);
+	return 0;
+    }
+
+    size_t *lengths = arena_alloc(context, (matcher->pattern_count + 1) * sizeof(size_t));
+    uint32_t state_count = 1;
+    size_t pattern_index = 0;
+
+    for ( ltbs_cell *tracker = patterns; pair_head(tracker); tracker = pair_rest(tracker), pattern_index++ )
+    {
+	ltbs_string *pattern = &pair_head(tracker)->data.string;
+	uint32_t state = 0;
+	int in_word = 0;
+
+	lengths[pattern_index] = pattern->length;
+
+	for ( unsigned int index = 0; index < pattern->length; index++ )
+	{
+	    byte value = pattern->strdata[index];
+	    int is_word = ascii_is_word(value);
+	    uint32_t steps[2];
+	    int step_count = 0;
+
+	    if ( whole_words && is_word && !in_word )
+		steps[step_count++] = boundary;
+
+	    steps[step_count++] = matcher->classes[(unsigned char) value];
+	    in_word = is_word;
+
+	    for ( int step = 0; step < step_count; step++ )
+	    {
+		uint32_t *edge = &table[state * stride + steps[step]];
+
+		if ( *edge == 0 )
+		    *edge = state_count++;
+
+		state = *edge;
+	    }
+	}
+
+	// Empty patterns never match; duplicates report the first copy.
+	if ( (state != 0) && (output[state] == 0) )
+	    output[state] = (uint32_t) pattern_index + 1;
+    }
+
+    // Breadth first, every missing edge borrows the edge of the failure
+    // state, which is shallower and already complete.
+    uint32_t *report = arena_alloc(context, state_count * sizeof(uint32_t));
+    uint32_t *report_next = arena_alloc(context, state_count * sizeof(uint32_t));
+    size_t head = 0;
+    size_t tail = 0;
+
+    report[0] = 0;
+    report_next[0] = 0;
+
+    for ( size_t class = 0; class < stride; class++ )
+	if ( table[class] != 0 )
+	    queue[tail++] = table[class];
+
+    while ( head < tail )
+    {
+	uint32_t state = queue[head++];
+
+	report[state] = output[state] ? state : report[fail[state]];
+	report_next[state] = report[fail[state]];
+
+	for ( size_t class = 0; class < stride; class++ )
+	{
+	    uint32_t *edge = &table[state * stride + class];
+	    uint32_t fallback = table[fail[state] * stride + class];
+
+	    if ( *edge != 0 )
+	    {
+		fail[*edge] = fallback;
+		queue[tail++] = *edge;
+	    }
+
+	    else *edge = fallback;
+	}
+    }
+
+    matcher->transitions = arena_alloc(context, state_count * stride * sizeof(uint32_t));
+    matcher->output = arena_alloc(context, state_count * sizeof(uint32_t));
+    memcpy(matcher->transitions, table, state_count * stride * sizeof(uint32_t));
+    memcpy(matcher->output, output, state_count * sizeof(uint32_t));
+    matcher->report = report;
+    matcher->report_next = report_next;
+    matcher->pattern_lengths = lengths;
+    matcher->state_count = state_count;
+
+    free(table);
+    free(output);
+    free(fail);
+    free(queue);
+
+    return matcher;
+}
+
+// Reports every pattern that ends in `state`, longest first.
+static size_t matcher_report(ltbs_matcher *matcher, uint32_t state, size_t end, match_fn callback, void *param)
+{
+    size_t found = 0;
+
+    for ( uint32_t at = matcher->report[state]; at != 0; at = matcher->report_next[at] )
+    {
+	size_t pattern = matcher->output[at] - 1;
+
+	if ( callback )
+	    callback(pattern, end - matcher->pattern_lengths[pattern], end, param);
+
+	found++;
+    }
+
+    return found;
+}
+
+ltbs_match_stream matcher_stream(ltbs_matcher *matcher)
+{
+    return (ltbs_match_stream) { .matcher = matcher };
+}
 
-/*     for (int index = 0; index < length_total; index++) */
-/*     { */
-/* 	if ( index < length1 ) */
-/* 	    buffer[index] = array1->data.array.arrdata[index]; */
-/* 	else */
-/* 	    buffer[index + length1] = array2->data.array.arrdata[index - length1]; */
-/*     } */
+// Offsets passed to `callback` count from the start of the stream. In
+// WHOLE_WORDS mode a match is only known to be whole once the next
+// byte is seen, so matches at the end of a chunk wait for the next
+// feed or for matcher_finish().
+size_t matcher_feed(ltbs_match_stream *stream, const byte *bytes, size_t length, match_fn callback, void *param)
+{
+    ltbs_matcher *matcher = stream->matcher;
+    const uint32_t *transitions = matcher->transitions;
+    const uint32_t *report = matcher->report;
+    size_t stride = matcher->class_count;
+    uint32_t state = stream->state;
+    size_t found = 0;
+
+    if ( !(matcher->options & LTBS_MATCH_WHOLE_WORDS) )
+    {
+	for ( size_t index = 0; index < length; index++ )
+	{
+	    state = transitions[state * stride + matcher->classes[(unsigned char) bytes[index]]];
+
+	    if ( report[state] != 0 )
+		found += matcher_report(matcher, state, stream->offset + index + 1, callback, param);
+	}
+    }
+
+    else
+    {
+	uint32_t boundary = (uint32_t) stride - 1;
+	int in_word = stream->in_word;
+
+	for ( size_t index = 0; index < length; index++ )
+	{
+	    int is_word = ascii_is_word(bytes[index]);
+
+	    if ( (report[state] != 0) && !(in_word && is_word) )
+		found += matcher_report(matcher, state, stream->offset + index, callback, param);
+
+	    if ( is_word && !in_word )
+		state = transitions[state * stride + boundary];
+
+	    state = transitions[state * stride + matcher->classes[(unsigned char) bytes[index]]];
+	    in_word = is_word;
+	}
+
+	stream->in_word = in_word;
+    }
+
+    stream->state = state;
+    stream->offset += length;
+
+    return found;
+}
+
+// Ends the stream, reporting the matches that were waiting on the byte
+// after them, and rewinds it so it can scan a new input from offset 0.
+size_t matcher_finish(ltbs_match_stream *stream, match_fn callback, void *param)
+{
+    size_t found = 0;
+
+    if ( (stream->matcher->options & LTBS_MATCH_WHOLE_WORDS) && (stream->matcher->report[stream->state] != 0) )
+	found = matcher_report(stream->matcher, stream->state, stream->offset, callback, param);
+
+    stream->state = 0;
+    stream->offset = 0;
+    stream->in_word = 0;
+
+    return found;
+}
+
+// Calls `callback` for every match in one pass and returns the number
+// of matches; `callback` may be 0 to only count them.
+size_t matcher_find_all(ltbs_matcher *matcher, ltbs_cell *string, match_fn callback, void *param)
+{
+    ltbs_match_stream stream = matcher_stream(matcher);
+    size_t found = matcher_feed(&stream, string->data.string.strdata, string->data.string.length, callback, param);
+
+    return found + matcher_finish(&stream, callback, param);
+}
+
+// Output of the JSON writer. With a file descriptor, the builder is
+// drained whenever it grows past JSON_FLUSH_SIZE, so memory use does
+// not depend on the size of the document.
+typedef struct json_output
+{
+    ltbs_string_builder *builder;
+    int fd;
+    int failed;
+} json_output;
+
+#define JSON_FLUSH_SIZE 65536
+
+static void json_drain(json_output *out)
+{
+#ifdef LTBS_POSIX
+    byte *cursor = out->builder->buffer;
+    size_t remaining = out->builder->length;
+
+    while ( (remaining > 0) && !out->failed )
+    {
+	ssize_t written = write(out->fd, cursor, remaining);
+
+	if ( written < 0 )
+	{
+	    if ( errno != EINTR )
+		out->failed = 1;
+
+	    continue;
+	}
+
+	cursor += written;
+	remaining -= (size_t) written;
+    }
+#else
+    errno = ENOSYS;
+    out->failed = 1;
+#endif
+
+    out->builder->length = 0;
+}
+
+static void json_maybe_drain(json_output *out)
+{
+    if ( (out->fd >= 0) && (out->builder->length >= JSON_FLUSH_SIZE) )
+	json_drain(out);
+}
+
+static const char JSON_HEX[] = "0123456789abcdef";
+
+// Characters JSON requires escaping: controls, the quote and backslash.
+static int json_needs_escape(unsigned char value)
+{
+    return (value < 0x20) || (value == '"') || (value == '\\');
+}
+
+// Index of the first byte at or after `index` that needs escaping in a
+// JSON string, or `length` if there is none.
+static size_t json_find_special(const byte *bytes, size_t index, size_t length)
+{
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    // Skip 16 clean bytes at a time: no control byte, quote or backslash.
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i last_control = _mm_set1_epi8(0x1F);
+
+    for ( ; index + 16 <= length; index += 16 )
+    {
+	__m128i block = _mm_loadu_si128((const __m128i *) &bytes[index]);
+	__m128i special = _mm_or_si128(
+	    _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+	    _mm_cmpeq_epi8(_mm_min_epu8(block, last_control), block)
+	);
+	unsigned int mask = (unsigned int) _mm_movemask_epi8(special);
+
+	if ( mask != 0 )
+	    return index + (size_t) __builtin_ctz(mask);
+    }
+#endif
+
+    while ( (index < length) && !json_needs_escape(bytes[index]) )
+	index++;
+
+    return index;
+}
+
+static void json_append_escaped(json_output *out, const byte *bytes, size_t length)
+{
+    size_t index = 0;
+    size_t run_start = 0;
+
+    while ( index < length )
+    {
+	index = json_find_special(bytes, index, length);
+	builder_append_bytes(out->builder, bytes + run_start, index - run_start);
+
+	if ( index == length )
+	    break;
+
+	unsigned char value = (unsigned char) bytes[index++];
+	run_start = index;
+
+	switch ( value )
+	{
+	    case '"': builder_append_bytes(out->builder, (const byte *) "\\\"", 2); break;
+	    case '\\': builder_append_bytes(out->builder, (const byte *) "\\\\", 2); break;
+	    case '\n': builder_append_bytes(out->builder, (const byte *) "\\n", 2); break;
+	    case '\r': builder_append_bytes(out->builder, (const byte *) "\\r", 2); break;
+	    case '\t': builder_append_bytes(out->builder, (const byte *) "\\t", 2); break;
+	    case '\b': builder_append_bytes(out->builder, (const byte *) "\\b", 2); break;
+	    case '\f': builder_append_bytes(out->builder, (const byte *) "\\f", 2); break;
+
+	    default:
+	    {
+		byte escape[6] = { '\\', 'u', '0', '0', JSON_HEX[value >> 4], JSON_HEX[value & 0xF] };
+		builder_append_bytes(out->builder, escape, sizeof(escape));
+	    }
+	    break;
+	}
+
+	json_maybe_drain(out);
+    }
+}
+
+static void json_append_string(json_output *out, const byte *bytes, size_t length)
+{
+    builder_append_byte(out->builder, '"');
+    json_append_escaped(out, bytes, length);
+    builder_append_byte(out->builder, '"');
+}
+
+// Opaque bytes (custom cells, arrays of non-cells) become hex strings.
+static void json_append_hex(json_output *out, const byte *bytes, size_t length)
+{
+    builder_append_byte(out->builder, '"');
+
+    for ( size_t index = 0; index < length; index++ )
+    {
+	unsigned char value = (unsigned char) bytes[index];
+	byte pair[2] = { JSON_HEX[value >> 4], JSON_HEX[value & 0xF] };
+	builder_append_bytes(out->builder, pair, 2);
+    }
+
+    builder_append_byte(out->builder, '"');
+}
+
+// One open container on the writer's explicit stack. Lists walk
+// `tracker`, arrays and hashmaps walk `index` over `cells` or `entries`.
+typedef struct json_frame
+{
+    ltbs_cell *container;
+    ltbs_cell *tracker;
+    ltbs_cell **entries;
+    size_t index;
+    size_t count;
+} json_frame;
+
+// The name an object member is written under: the key's own bytes, or
+// the decimal text of an integer key, built in `digits`.
+static const byte *json_key_name(ltbs_cell *key, byte digits[21], size_t *length)
+{
+    if ( !(key->data.string.flags & (LTBS_STRING_INT_KEY | LTBS_STRING_UINT_KEY)) )
+    {
+	*length = key->data.string.length;
+	return key->data.string.strdata;
+    }
+
+    uint64_t bits = hash_key_uint(key);
+    int negative = (key->data.string.flags & LTBS_STRING_INT_KEY) && ((int64_t) bits < 0);
+    byte *end = digits + 21;
+    byte *start = ltbs_write_uint(end, negative ? 0 - bits : bits);
+
+    if ( negative )
+	*--start = '-';
+
+    *length = (size_t) (end - start);
+    return start;
+}
+
+static int json_compare_entries(const void *lhs, const void *rhs)
+{
+    byte digits1[21];
+    byte digits2[21];
+    size_t length1;
+    size_t length2;
+    const byte *name1 = json_key_name(*(ltbs_cell * const *) lhs, digits1, &length1);
+    const byte *name2 = json_key_name(*(ltbs_cell * const *) rhs, digits2, &length2);
+    size_t shorter = length1 < length2 ? length1 : length2;
+    int result = memcmp(name1, name2, shorter);
+
+    if ( result != 0 )
+	return result;
+
+    return (length1 > length2) - (length1 < length2);
+}
+
+#define json_is_object(cell) (((cell)->type == LTBS_HASHMAP) || ((cell)->type == LTBS_FLATMAP))
+
+// Collects the key/value pairs of either hashmap engine as alternating
+// entries, sized from the map's count. The result is malloc()ed.
+static ltbs_cell **json_collect_entries(ltbs_cell *map, size_t *count, int canonical)
+{
+    size_t capacity = 2 * hash_count(&map) + 2;
+    ltbs_cell **entries = malloc(sizeof(ltbs_cell *) * capacity);
+    ltbs_hash_iter iter = hash_iter(&map);
+
+    *count = 0;
+
+    while ( hash_next(&iter, &entries[*count * 2], &entries[*count * 2 + 1]) )
+    {
+	(*count)++;
+
+	if ( *count * 2 + 2 > capacity )
+	{
+	    capacity *= 2;
+	    entries = realloc(entries, sizeof(ltbs_cell *) * capacity);
+	}
+    }
+
+    if ( canonical )
+	qsort(entries, *count, sizeof(ltbs_cell *) * 2, json_compare_entries);
+
+    return entries;
+}
+
+static void json_newline(json_output *out, size_t depth, int options)
+{
+    if ( !(options & LTBS_JSON_PRETTY) )
+	return;
+
+    builder_append_byte(out->builder, '\n');
+
+    for ( size_t level = 0; level < depth; level++ )
+	builder_append_bytes(out->builder, (const byte *) "  ", 2);
+}
+
+// Writes a scalar, or opens a container and returns 1 so the caller
+// pushes `frame`.
+static int json_open_value(json_output *out, ltbs_cell *value, json_frame *frame, int options)
+{
+    *frame = (json_frame) {0};
+
+    if ( (value == 0) || (value == pair_nil()) )
+    {
+	builder_append_bytes(out->builder, (const byte *) "null", 4);
+	return 0;
+    }
+
+    switch ( value->type )
+    {
+	case LTBS_STRING:
+	    json_append_string(out, value->data.string.strdata, value->data.string.length);
+	    return 0;
+
+	case LTBS_ROPE:
+	{
+	    ltbs_rope_iter iter = rope_iter(value);
+	    ltbs_cell chunk;
+
+	    builder_append_byte(out->builder, '"');
+
+	    while ( rope_next(&iter, &chunk) )
+		json_append_escaped(out, chunk.data.string.strdata, chunk.data.string.length);
+
+	    builder_append_byte(out->builder, '"');
+	}
+	return 0;
+
+	case LTBS_BYTE: builder_append_uint(out->builder, (unsigned char) value->data.byteval); return 0;
+	case LTBS_INT: builder_append_int(out->builder, value->data.integer); return 0;
+	case LTBS_UINT: builder_append_uint(out->builder, value->data.uinteger); return 0;
+
+	case LTBS_FLOAT:
+	{
+	    byte digits[32];
+	    int length = ltbs_write_float(digits, value->data.floatval);
+
+	    // JSON has no spelling for infinities and NaN.
+	    if ( (digits[length - 1] == 'f') || (digits[0] == 'n') )
+		builder_append_bytes(out->builder, (const byte *) "null", 4);
+
+	    else builder_append_bytes(out->builder, digits, (size_t) length);
+	}
+	return 0;
+
+	case LTBS_CUSTOM:
+	    json_append_hex(out, value->data.custom.data, value->data.custom.size);
+	    return 0;
+
+	case LTBS_ARRAY:
+	    if ( value->data.array.elem_size != sizeof(ltbs_cell) )
+	    {
+		json_append_hex(out, value->data.array.buffer, value->data.array.total_size);
+		return 0;
+	    }
+
+	    builder_append_byte(out->builder, '[');
+	    frame->container = value;
+	    frame->count = value->data.array.total_size / sizeof(ltbs_cell);
+	    return 1;
+
+	case LTBS_PAIR:
+	    builder_append_byte(out->builder, '[');
+	    frame->container = value;
+	    frame->tracker = value;
+	    return 1;
+
+	case LTBS_HASHMAP:
+	case LTBS_FLATMAP:
+	    builder_append_byte(out->builder, '{');
+	    frame->container = value;
+	    frame->entries = json_collect_entries(value, &frame->count, options & LTBS_JSON_CANONICAL);
+	    return 1;
+
+	default:
+	    builder_append_bytes(out->builder, (const byte *) "null", 4);
+	    return 0;
+    }
+}
+
+static void json_emit(json_output *out, ltbs_cell *value, int options)
+{
+    size_t capacity = 16;
+    size_t depth = 0;
+    json_frame *stack = malloc(sizeof(json_frame) * capacity);
+
+    if ( json_open_value(out, value, &stack[0], options) )
+	depth = 1;
+
+    while ( (depth > 0) && !out->failed )
+    {
+	json_frame *frame = &stack[depth - 1];
+	ltbs_cell *next = 0;
+	int has_next = 0;
+	int first = frame->index == 0;
+
+	switch ( frame->container->type )
+	{
+	    case LTBS_PAIR:
+		if ( pair_head(frame->tracker) != 0 )
+		{
+		    next = pair_head(frame->tracker);
+		    frame->tracker = pair_rest(frame->tracker);
+		    has_next = 1;
+		}
+		break;
+
+	    case LTBS_ARRAY:
+		if ( frame->index < frame->count )
+		{
+		    next = &((ltbs_cell *) frame->container->data.array.buffer)[frame->index];
+		    has_next = 1;
+		}
+		break;
+
+	    default:
+		if ( frame->index < frame->count )
+		{
+		    next = frame->entries[frame->index * 2 + 1];
+		    has_next = 1;
+		}
+		break;
+	}
+
+	if ( !has_next )
+	{
+	    int is_object = json_is_object(frame->container);
+
+	    if ( !first )
+		json_newline(out, depth - 1, options);
+
+	    builder_append_byte(out->builder, is_object ? '}' : ']');
+	    free(frame->entries);
+	    depth--;
+	    continue;
+	}
+
+	if ( !first )
+	    builder_append_byte(out->builder, ',');
+
+	json_newline(out, depth, options);
+
+	if ( json_is_object(frame->container) )
+	{
+	    ltbs_cell *key = frame->entries[frame->index * 2];
+
+	    byte digits[21];
+	    size_t length;
+	    const byte *name = json_key_name(key, digits, &length);
+
+	    json_append_string(out, name, length);
+	    builder_append_bytes(out->builder, (const byte *) ": ", options & LTBS_JSON_PRETTY ? 2 : 1);
+	}
+
+	frame->index++;
+
+	if ( depth == capacity )
+	{
+	    capacity *= 2;
+	    stack = realloc(stack, sizeof(json_frame) * capacity);
+	}
+
+	if ( json_open_value(out, next, &stack[depth], options) )
+	    depth++;
+
+	json_maybe_drain(out);
+    }
+
+    // Release the entry lists of frames left open by a failed write.
+    while ( depth > 0 )
+	free(stack[--depth].entries);
+
+    free(stack);
+}
+
+// Appends `value` as JSON. The empty list returned by pair_nil() stands
+// for null, other lists and arrays of cells become JSON arrays and
+// hashmaps become objects, in trie order unless LTBS_JSON_CANONICAL asks
+// for keys sorted by their bytes. Integer keys are written, and sorted,
+// as their decimal text. Custom cells and arrays of other element types
+// are written as hex strings.
+void json_write(ltbs_string_builder *builder, ltbs_cell *value, int options)
+{
+    json_output out = { .builder = builder, .fd = -1, .failed = 0 };
+    json_emit(&out, value, options);
+}
+
+ltbs_cell *json_serialize(ltbs_cell *value, int options, Arena *context)
+{
+    ltbs_string_builder builder = builder_new(0, context);
+
+    json_write(&builder, value, options);
+    return builder_finish(&builder);
+}
+
+// Streams `value` as JSON to a file descriptor through a bounded buffer
+// allocated from `context`. Returns 0 on success and -1 with errno set
+// when a write fails.
+int json_write_fd(int fd, ltbs_cell *value, int options, Arena *context)
+{
+    ltbs_string_builder builder = builder_new(JSON_FLUSH_SIZE, context);
+    json_output out = { .builder = &builder, .fd = fd, .failed = 0 };
+
+    json_emit(&out, value, options);
+
+    if ( !out.failed )
+	json_drain(&out);
+
+    return out.failed ? -1 : 0;
+}
+
+// Serializes `data_map` as JSON. `format` lists writer options by name,
+// e.g. "pretty", "canonical" or "pretty canonical"; 0 or "" gives
+// compact output in trie order.
+ltbs_cell *format_serialize(char *format, ltbs_cell *data_map, Arena *context)
+{
+    int options = 0;
+
+    if ( format != 0 )
+    {
+	if ( strstr(format, "pretty") ) options |= LTBS_JSON_PRETTY;
+	if ( strstr(format, "canonical") ) options |= LTBS_JSON_CANONICAL;
+    }
+
+    return json_serialize(data_map, options, context);
+}
+
+// Stage 1 of the JSON parser: a structural index. The input is
+// classified 64 bytes at a time into bitmasks; quotes escaped by an odd
+// run of backslashes are dropped, and a prefix xor of the remaining
+// quotes marks every byte inside a string. What is left are the offsets
+// of brackets, colons and commas outside strings, of opening quotes and
+// of the first byte of every other scalar.
+typedef struct json_block_masks
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;
+    uint64_t space;
+} json_block_masks;
+
+static json_block_masks json_classify_block(const byte *block)
+{
+    json_block_masks result = {0};
+
+#if defined(LTBS_X86_SIMD) && defined(__SSE2__)
+    for ( int part = 0; part < 4; part++ )
+    {
+	__m128i bytes = _mm_loadu_si128((const __m128i *) &block[part * 16]);
+	int shift = part * 16;
+
+	__m128i op = _mm_or_si128(
+	    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('{')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('}'))),
+	    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('[')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(']')))
+	);
+	op = _mm_or_si128(
+	    op,
+	    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(',')))
+	);
+
+	__m128i space = _mm_or_si128(
+	    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))),
+	    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')))
+	);
+
+	result.quote |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'))) << shift;
+	result.backslash |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))) << shift;
+	result.op |= (uint64_t) (uint16_t) _mm_movemask_epi8(op) << shift;
+	result.space |= (uint64_t) (uint16_t) _mm_movemask_epi8(space) << shift;
+    }
+#else
+    for ( int index = 0; index < 64; index++ )
+    {
+	uint64_t bit = (uint64_t) 1 << index;
+
+	switch ( block[index] )
+	{
+	    case '"': result.quote |= bit; break;
+	    case '\\': result.backslash |= bit; break;
+	    case '{': case '}': case '[': case ']': case ':': case ',': result.op |= bit; break;
+	    case ' ': case '\t': case '\n': case '\r': result.space |= bit; break;
+	    default: break;
+	}
+    }
+#endif
+
+    return result;
+}
+
+// Bit i of the result is the xor of bits 0..i of `value`.
+static uint64_t json_prefix_xor(uint64_t value)
+{
+    value ^= value << 1;
+    value ^= value << 2;
+    value ^= value << 4;
+    value ^= value << 8;
+    value ^= value << 16;
+    value ^= value << 32;
+
+    return value;
+}
+
+// Marks the bytes escaped by a backslash. Backslashes are rare, so they
+// are walked one by one; `carry` is set when the block ends in an
+// unpaired backslash.
+static uint64_t json_escaped_bytes(uint64_t backslash, uint64_t *carry)
+{
+    uint64_t result = *carry;
+
+    *carry = 0;
+
+    while ( backslash != 0 )
+    {
+	int index = __builtin_ctzll(backslash);
+	backslash &= backslash - 1;
+
+	if ( (result >> index) & 1 )
+	    continue;
+
+	if ( index == 63 )
+	    *carry = 1;
+
+	else result |= (uint64_t) 1 << (index + 1);
+    }
+
+    return result;
+}
+
+// Fills `index` with structural offsets and returns how many there are,
+// or -1 when a string is left open.
+static int64_t json_build_index(const byte *input, size_t length, uint32_t *index)
+{
+    uint64_t escape_carry = 0;
+    uint64_t string_carry = 0;
+    uint64_t separator_carry = 1;
+    int64_t count = 0;
+
+    for ( size_t base = 0; base < length; base += 64 )
+    {
+	byte padded[64];
+	const byte *block = &input[base];
+
+	if ( length - base < 64 )
+	{
+	    memset(padded, ' ', sizeof(padded));
+	    memcpy(padded, block, length - base);
+	    block = padded;
+	}
+
+	json_block_masks masks = json_classify_block(block);
+	uint64_t quotes = masks.quote & ~json_escaped_bytes(masks.backslash, &escape_carry);
+	uint64_t in_string = json_prefix_xor(quotes) ^ string_carry;
+	uint64_t separators = masks.op | masks.space | quotes;
+	uint64_t scalars = ~(separators | in_string);
+	uint64_t follows_separator = (separators << 1) | separator_carry;
+	uint64_t structurals = (masks.op & ~in_string) | (quotes & in_string) | (scalars & follows_separator);
+
+	string_carry = (uint64_t) ((int64_t) in_string >> 63);
+	separator_carry = separators >> 63;
+
+	while ( structurals != 0 )
+	{
+	    index[count++] = (uint32_t) (base + (size_t) __builtin_ctzll(structurals));
+	    structurals &= structurals - 1;
+	}
+    }
 
-/*     return result; */
-/* } */
+    return string_carry ? -1 : count;
+}
 
-ltbs_cell *array_copy(ltbs_cell *array, Arena *destination)
+// Stage 2 state: the input, the structural index and a cursor into it.
+typedef struct json_parser
 {
-    int length = array->data.array.total_size / array->data.array.elem_size;
-    int total_buffer_size = array->data.array.total_size;
-    char *buffer = array->data.array.buffer;
-    char *dest_buffer = arena_alloc(destination, total_buffer_size);
-    ltbs_cell *result = ltbs_alloc(destination);
+    const byte *input;
+    size_t length;
+    uint32_t *index;
+    size_t count;
+    size_t next;
+    int options;
+    Arena *context;
+    ltbs_json_status *status;
+} json_parser;
 
-    result->type = LTBS_ARRAY;
-    result->data.array.elem_size = array->data.array.elem_size;
-    result->data.array.total_size = array->data.array.total_size;
-    result->data.array.buffer = dest_buffer;
+static void json_fail(json_parser *parser, size_t offset, const char *message)
+{
+    if ( parser->status->ok )
+    {
+	parser->status->ok = 0;
+	parser->status->offset = offset;
+	parser->status->message = message;
+    }
+}
 
-    for ( int index = 0; index < total_buffer_size; index++ )
-	dest_buffer[index] = buffer[index];
+static int json_is_delimiter(json_parser *parser, size_t offset)
+{
+    if ( offset >= parser->length )
+	return 1;
 
-    return result;
+    switch ( parser->input[offset] )
+    {
+	case ' ': case '\t': case '\n': case '\r':
+	case ',': case ':': case '[': case ']': case '{': case '}':
+	    return 1;
+
+	default:
+	    return 0;
+    }
 }
 
-void array_set_index(ltbs_cell *array, void *value, int index)
+static int json_hex_value(byte digit)
 {
-    size_t offset = array->data.array.elem_size * index;
-    size_t elem = array->data.array.elem_size;
-    char *as_buffer = value;
-    char *destination = array->data.array.buffer;
+    if ( (digit >= '0') && (digit <= '9') ) return digit - '0';
+    if ( (digit >= 'a') && (digit <= 'f') ) return digit - 'a' + 10;
+    if ( (digit >= 'A') && (digit <= 'F') ) return digit - 'A' + 10;
 
-    for ( size_t index = 0; index < elem; index++ )
-	destination[offset + index] = as_buffer[index];
+    return -1;
 }
 
-ltbs_cell *hash_make(Arena *context)
+static int json_read_hex4(const byte *digits)
 {
-    ltbs_cell *result = ltbs_alloc(context);
-    result->type = LTBS_HASHMAP;
-    result->data.hashmap.children[0] = 0;
-    result->data.hashmap.children[1] = 0;
-    result->data.hashmap.children[2] = 0;
-    result->data.hashmap.children[3] = 0;
-    result->data.hashmap.value = 0;
-    result->data.hashmap.key = 0;
+    int result = 0;
+
+    for ( int index = 0; index < 4; index++ )
+    {
+	int value = json_hex_value(digits[index]);
+
+	if ( value < 0 )
+	    return -1;
+
+	result = (result << 4) | value;
+    }
 
     return result;
 }
 
-uint64_t hash_compute(ltbs_string *key)
+// Parses the string whose opening quote is at `start`. Strings without
+// escapes are views into the input; others are unescaped into the arena.
+static ltbs_cell *json_parse_string(json_parser *parser, size_t start)
 {
-    int result = 0x100;
+    const byte *input = parser->input;
+    size_t cursor = json_find_special(input, start + 1, parser->length);
+
+    if ( (cursor < parser->length) && (input[cursor] == '"') )
+    {
+	ltbs_cell *result = ltbs_alloc(parser->context);
+
+	result->type = LTBS_STRING;
+	result->data.string.strdata = (byte *) &input[start + 1];
+	result->data.string.length = (unsigned int) (cursor - start - 1);
+	return result;
+    }
+
+    // Unescaped text is never longer than its escaped form.
+    size_t end = cursor;
+
+    while ( (end < parser->length) && (input[end] != '"') )
+	end += input[end] == '\\' ? 2 : 1;
+
+    if ( end >= parser->length )
+    {
+	json_fail(parser, start, "unterminated string");
+	return 0;
+    }
 
-    for (uint64_t index = 0; index < key->length - 1; index++)
+    byte *buffer = arena_alloc(parser->context, end - start);
+    size_t written = cursor - start - 1;
+
+    memcpy(buffer, &input[start + 1], written);
+
+    while ( cursor < end )
     {
-	result ^= key->strdata[index];
-	result *= HASH_FACTOR;
+	unsigned char current = (unsigned char) input[cursor];
+
+	if ( current < 0x20 )
+	{
+	    json_fail(parser, cursor, "control character in string");
+	    return 0;
+	}
+
+	if ( current != '\\' )
+	{
+	    size_t run_end = json_find_special(input, cursor, end);
+
+	    if ( run_end == cursor )
+		run_end++;
+
+	    memcpy(&buffer[written], &input[cursor], run_end - cursor);
+	    written += run_end - cursor;
+	    cursor = run_end;
+	    continue;
+	}
+
+	byte escape = input[cursor + 1];
+	cursor += 2;
+
+	switch ( escape )
+	{
+	    case '"': buffer[written++] = '"'; break;
+	    case '\\': buffer[written++] = '\\'; break;
+	    case '/': buffer[written++] = '/'; break;
+	    case 'b': buffer[written++] = '\b'; break;
+	    case 'f': buffer[written++] = '\f'; break;
+	    case 'n': buffer[written++] = '\n'; break;
+	    case 'r': buffer[written++] = '\r'; break;
+	    case 't': buffer[written++] = '\t'; break;
+
+	    case 'u':
+	    {
+		int unit = cursor + 4 <= end ? json_read_hex4(&input[cursor]) : -1;
+		uint32_t codepoint = (uint32_t) unit;
+
+		if ( unit < 0 )
+		{
+		    json_fail(parser, cursor - 2, "invalid \\u escape");
+		    return 0;
+		}
+
+		cursor += 4;
+
+		// A high surrogate must be followed by an escaped low one.
+		if ( (unit >= 0xD800) && (unit <= 0xDBFF) )
+		{
+		    int low = ((cursor + 6 <= end) && (input[cursor] == '\\') && (input[cursor + 1] == 'u'))
+			? json_read_hex4(&input[cursor + 2])
+			: -1;
+
+		    if ( (low < 0xDC00) || (low > 0xDFFF) )
+		    {
+			json_fail(parser, cursor - 6, "unpaired surrogate");
+			return 0;
+		    }
+
+		    codepoint = 0x10000 + (((uint32_t) unit - 0xD800) << 10) + ((uint32_t) low - 0xDC00);
+		    cursor += 6;
+		}
+
+		else if ( (unit >= 0xDC00) && (unit <= 0xDFFF) )
+		{
+		    json_fail(parser, cursor - 6, "unpaired surrogate");
+		    return 0;
+		}
+
+		written += utf8_encode(&buffer[written], codepoint);
+	    }
+	    break;
+
+	    default:
+		json_fail(parser, cursor - 2, "invalid escape");
+		return 0;
+	}
     }
 
+    ltbs_cell *result = ltbs_alloc(parser->context);
+
+    result->type = LTBS_STRING;
+    result->data.string.strdata = buffer;
+    result->data.string.length = (unsigned int) written;
     return result;
 }
 
-ltbs_cell *hash_upsert(ltbs_cell **map, ltbs_cell *key, ltbs_cell *value, Arena *context)
+// Integers that fit become LTBS_INT (or LTBS_UINT above INT64_MAX);
+// anything with a fraction or exponent becomes LTBS_FLOAT.
+static ltbs_cell *json_parse_number(json_parser *parser, size_t start)
 {
-    ltbs_cell *result = 0;
-    
-    for (uint64_t hash = hash_compute(&key->data.string); *map; hash <<= 2)
-    {	
-	if ( ((*map)->data.hashmap.key != 0) &&
-	     string_compare(key, (*map)->data.hashmap.key) )
+    const byte *input = parser->input;
+    size_t cursor = start;
+    int negative = 0;
+    int is_integer = 1;
+    int overflow = 0;
+    uint64_t magnitude = 0;
+
+    if ( input[cursor] == '-' )
+    {
+	negative = 1;
+	cursor++;
+    }
+
+    if ( (cursor >= parser->length) || (input[cursor] < '0') || (input[cursor] > '9') )
+    {
+	json_fail(parser, start, "invalid number");
+	return 0;
+    }
+
+    if ( input[cursor] == '0' )
+	cursor++;
+
+    else while ( (cursor < parser->length) && (input[cursor] >= '0') && (input[cursor] <= '9') )
+    {
+	uint64_t digit = (uint64_t) (input[cursor] - '0');
+
+	if ( magnitude > (UINT64_MAX - digit) / 10 )
+	    overflow = 1;
+
+	magnitude = magnitude * 10 + digit;
+	cursor++;
+    }
+
+    if ( (cursor < parser->length) && (input[cursor] == '.') )
+    {
+	is_integer = 0;
+	cursor++;
+
+	if ( (cursor >= parser->length) || (input[cursor] < '0') || (input[cursor] > '9') )
 	{
-	    if ( (context != 0) && (value != 0) )
-	    {
-		(*map)->data.hashmap.value = value;
-		result = value;
-	        return result;
-	    }
-	    
-	    result = (*map)->data.hashmap.value;
-	    return result;
+	    json_fail(parser, start, "invalid number");
+	    return 0;
 	}
 
-	map = &(*map)->data.hashmap.children[hash >> 62];
+	while ( (cursor < parser->length) && (input[cursor] >= '0') && (input[cursor] <= '9') )
+	    cursor++;
     }
 
-    if ( (context != 0) && (value != 0) )
+    if ( (cursor < parser->length) && ((input[cursor] == 'e') || (input[cursor] == 'E')) )
     {
-	ltbs_cell *key_copy = string_copy(key, context);
-	*map = hash_make(context);
-	(*map)->data.hashmap.key = key_copy;
-	(*map)->data.hashmap.value = value;
+	is_integer = 0;
+	cursor++;
 
-	result = value;
+	if ( (cursor < parser->length) && ((input[cursor] == '+') || (input[cursor] == '-')) )
+	    cursor++;
+
+	if ( (cursor >= parser->length) || (input[cursor] < '0') || (input[cursor] > '9') )
+	{
+	    json_fail(parser, start, "invalid number");
+	    return 0;
+	}
+
+	while ( (cursor < parser->length) && (input[cursor] >= '0') && (input[cursor] <= '9') )
+	    cursor++;
     }
-    
+
+    if ( !json_is_delimiter(parser, cursor) )
+    {
+	json_fail(parser, cursor, "invalid number");
+	return 0;
+    }
+
+    ltbs_cell *result = ltbs_alloc(parser->context);
+
+    if ( is_integer && !overflow && (!negative || (magnitude <= (uint64_t) INT64_MAX + 1)) )
+    {
+	if ( negative || (magnitude <= INT64_MAX) )
+	{
+	    result->type = LTBS_INT;
+	    result->data.integer = negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+	}
+
+	else
+	{
+	    result->type = LTBS_UINT;
+	    result->data.uinteger = magnitude;
+	}
+
+	return result;
+    }
+
+    // The grammar above is a subset of what string_to_double() reads.
+    ltbs_cell digits = {0};
+    double value = 0;
+
+    digits.type = LTBS_STRING;
+    digits.data.string.strdata = (byte *) &input[start];
+    digits.data.string.length = (unsigned int) (cursor - start);
+    string_to_double(&digits, &value);
+
+    result->type = LTBS_FLOAT;
+    result->data.floatval = (float) value;
     return result;
 }
 
-ltbs_cell *hash_lookup(ltbs_cell **map, byte *cstring)
+static ltbs_cell *json_parse_literal(json_parser *parser, size_t start)
 {
-    Arena *scratch = malloc(sizeof(Arena));
-    *scratch = (Arena) {0};
-    ltbs_cell *result = 0;
-    
-    ltbs_cell *key = string_from_cstring(cstring, scratch);
-    result = hash_upsert(map, key, 0, 0);
-    
-    arena_free(scratch);
-    free(scratch);
+    static const char *names[3] = { "true", "false", "null" };
+    size_t remaining = parser->length - start;
 
-    return result;
+    for ( int which = 0; which < 3; which++ )
+    {
+	size_t length = strlen(names[which]);
+
+	if ( (remaining < length) ||
+	     (memcmp(&parser->input[start], names[which], length) != 0) ||
+	     !json_is_delimiter(parser, start + length) )
+	    continue;
+
+	if ( which == 2 )
+	    return pair_nil();
+
+	return int_from_int(which == 0, parser->context);
+    }
+
+    json_fail(parser, start, "invalid literal");
+    return 0;
+}
+
+static ltbs_cell *json_parse_scalar(json_parser *parser, size_t start)
+{
+    switch ( parser->input[start] )
+    {
+	case '"': return json_parse_string(parser, start);
+	case 't': case 'f': case 'n': return json_parse_literal(parser, start);
+	default: return json_parse_number(parser, start);
+    }
+}
+
+// An open array or object during stage 2. Arrays are built as lists
+// through `tail`; objects through `container` with `key` pending.
+typedef struct json_parse_frame
+{
+    ltbs_cell *container;
+    ltbs_cell **tail;
+    ltbs_cell *key;
+    byte closer;
+} json_parse_frame;
+
+static int json_take(json_parser *parser, size_t *offset)
+{
+    if ( parser->next >= parser->count )
+	return 0;
+
+    *offset = parser->index[parser->next++];
+    return 1;
 }
 
-void __hash_keys_impl(ltbs_cell **map, ltbs_cell **out_list, Arena *context)
+// Reads `"key" :` into the frame.
+static int json_parse_key(json_parser *parser, json_parse_frame *frame)
 {
-    ltbs_cell *key = (*map)->data.hashmap.key;
-    *out_list = pair_cons(key, *out_list, context);
+    size_t offset = parser->length;
+
+    if ( !json_take(parser, &offset) || (parser->input[offset] != '"') )
+    {
+	json_fail(parser, offset, "expected object key");
+	return 0;
+    }
+
+    frame->key = json_parse_string(parser, offset);
+
+    if ( frame->key == 0 )
+	return 0;
 
-    for (int index = 0; index < 4; index++)
+    if ( !json_take(parser, &offset) || (parser->input[offset] != ':') )
     {
-	ltbs_cell *child = (*map)->data.hashmap.children[index];
-	if ( child != 0 ) __hash_keys_impl(&child, out_list, context);
+	json_fail(parser, offset, "expected ':'");
+	return 0;
     }
+
+    return 1;
 }
 
-ltbs_cell *hash_keys(ltbs_cell **map, Arena *context)
+// Adds a parsed value to the innermost open container. Object keys are
+// adopted by the trie without a copy, stamped with their hash like any
+// stored key; a repeated key keeps its last value.
+static void json_frame_add(json_parser *parser, json_parse_frame *frame, ltbs_cell *value)
 {
-    ltbs_cell *result = ltbs_alloc(context); *result = PAIR_NIL;
-    __hash_keys_impl(map, &result, context);
+    if ( frame->closer == ']' )
+    {
+	*frame->tail = pair_cons(value, *frame->tail, parser->context);
+	frame->tail = &(*frame->tail)->data.pair.rest;
+	return;
+    }
+
+    ltbs_cell *key = frame->key;
+    uint64_t hash = hash_compute(&key->data.string);
+    ltbs_cell **slot = hash_find_slot(&frame->container, key->data.string.strdata, key->data.string.length, hash);
+
+    if ( *slot == 0 )
+    {
+	*slot = hash_make(parser->context);
+	(*slot)->data.hashmap.key = hash_stored_key(key->data.string.strdata, key->data.string.length,
+						    hash, key, 0, parser->context);
+	frame->container->data.hashmap.count++;
+    }
+
+    (*slot)->data.hashmap.value = value;
+}
+
+static ltbs_cell *json_frame_close(json_parser *parser, json_parse_frame *frame)
+{
+    if ( (frame->closer == ']') && (parser->options & LTBS_JSON_ARRAYS) )
+	return pair_to_array(frame->container, parser->context);
+
+    return frame->container;
+}
+
+static ltbs_cell *json_parse_document(json_parser *parser)
+{
+    size_t capacity = 16;
+    size_t depth = 0;
+    json_parse_frame *stack = malloc(sizeof(json_parse_frame) * capacity);
+    ltbs_cell *result = 0;
+    size_t offset = 0;
+
+    while ( parser->status->ok )
+    {
+	ltbs_cell *value = 0;
+
+	if ( !json_take(parser, &offset) )
+	{
+	    json_fail(parser, parser->length, "unexpected end of input");
+	    break;
+	}
+
+	byte current = parser->input[offset];
+
+	if ( (current == '[') || (current == '{') )
+	{
+	    if ( depth == capacity )
+	    {
+		capacity *= 2;
+		stack = realloc(stack, sizeof(json_parse_frame) * capacity);
+	    }
+
+	    json_parse_frame *frame = &stack[depth++];
+	    size_t peek = parser->next < parser->count ? parser->index[parser->next] : parser->length;
+
+	    *frame = (json_parse_frame) {0};
+	    frame->closer = current == '[' ? ']' : '}';
+
+	    if ( current == '[' )
+	    {
+		frame->container = ltbs_alloc(parser->context);
+		*frame->container = PAIR_NIL;
+		frame->tail = &frame->container;
+	    }
+
+	    else frame->container = hash_make(parser->context);
+
+	    if ( (peek < parser->length) && (parser->input[peek] == frame->closer) )
+	    {
+		parser->next++;
+		value = json_frame_close(parser, frame);
+		depth--;
+	    }
+
+	    else
+	    {
+		if ( (current == '{') && !json_parse_key(parser, frame) )
+		    break;
+
+		continue;
+	    }
+	}
+
+	else if ( (current == ']') || (current == '}') || (current == ',') || (current == ':') )
+	{
+	    json_fail(parser, offset, "expected a value");
+	    break;
+	}
+
+	else
+	{
+	    value = json_parse_scalar(parser, offset);
+
+	    if ( value == 0 )
+		break;
+	}
+
+	// Attach the finished value and close every container it completes.
+	for (;;)
+	{
+	    if ( depth == 0 )
+	    {
+		result = value;
+		break;
+	    }
+
+	    json_parse_frame *frame = &stack[depth - 1];
+	    json_frame_add(parser, frame, value);
+
+	    if ( !json_take(parser, &offset) )
+	    {
+		json_fail(parser, parser->length, "unexpected end of input");
+		break;
+	    }
+
+	    if ( parser->input[offset] == ',' )
+	    {
+		if ( frame->closer == '}' )
+		    json_parse_key(parser, frame);
+
+		break;
+	    }
+
+	    if ( parser->input[offset] != frame->closer )
+	    {
+		json_fail(parser, offset, "expected ',' or a closing bracket");
+		break;
+	    }
+
+	    value = json_frame_close(parser, frame);
+	    depth--;
+	}
+
+	if ( result != 0 )
+	    break;
+    }
+
+    free(stack);
+
+    if ( parser->status->ok && (parser->next < parser->count) )
+	json_fail(parser, parser->index[parser->next], "trailing content after document");
+
+    return parser->status->ok ? result : 0;
+}
+
+// Parses the JSON document in `text` into cells allocated from
+// `context`: objects become hash tries, arrays become lists (or arrays
+// of cells with LTBS_JSON_ARRAYS), true and false become the integers 1
+// and 0 and null becomes pair_nil(). Strings without escapes are views
+// into `text`, which must outlive the result. Returns 0 on error and
+// describes it in `status` when that is not 0.
+ltbs_cell *json_parse(ltbs_cell *text, int options, Arena *context, ltbs_json_status *status)
+{
+    ltbs_json_status ignored;
+    json_parser parser = {0};
+
+    parser.status = status != 0 ? status : &ignored;
+    *parser.status = (ltbs_json_status) { .ok = 1, .offset = 0, .message = 0 };
+    parser.input = text->data.string.strdata;
+    parser.length = text->data.string.length;
+    parser.options = options;
+    parser.context = context;
+    parser.index = malloc(sizeof(uint32_t) * (parser.length + 1));
+
+    int64_t count = json_build_index(parser.input, parser.length, parser.index);
+    ltbs_cell *result = 0;
+
+    if ( count < 0 )
+	json_fail(&parser, parser.length, "unterminated string");
+
+    else
+    {
+	parser.count = (size_t) count;
+	result = json_parse_document(&parser);
+    }
+
+    free(parser.index);
     return result;
 }
 
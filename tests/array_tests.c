@@ -129,6 +129,36 @@ int main()
     
     printf("\n----------------------\n");
 
+    printf("\n----------------------\n");
+    printf("Array_Vt.copy() of inline strings");
+    printf("\n----------------------\n");
+
+    ltbs_cell *short_string = String_Vt.cs("short", &global);
+    ltbs_cell *strings_copy;
+    ltbs_cell *strings_set = Array_Vt.new_array(sizeof(ltbs_cell), sizeof(ltbs_cell) * 2, &global);
+
+    {
+	Arena scratch = {0};
+	ltbs_cell *strings = List_Vt.cons(
+	    short_string,
+	    List_Vt.cons(String_Vt.cs("scratch", &scratch), List_Vt.nil(), &scratch),
+	    &scratch
+	);
+
+	strings_copy = Array_Vt.copy(Array_Vt.from_list(strings, &scratch), &global);
+	Array_Vt.set_index(strings_set, short_string, 0);
+	Array_Vt.set_index(strings_set, String_Vt.cs("set", &scratch), 1);
+
+	arena_free(&scratch);
+    }
+
+    for ( int index = 0; index < 2; index++ )
+	printf("copied: %s, set: %s\n",
+	       ((ltbs_cell *) Array_Vt.at_index(strings_copy, index))->data.string.strdata,
+	       ((ltbs_cell *) Array_Vt.at_index(strings_set, index))->data.string.strdata);
+
+    printf("\n----------------------\n");
+
     arena_free(&global);
     
     return 0;
@@ -0,0 +1,145 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#define LIBBLACKSQUID_IMPLEMENTATION
+#include "../libblacksquid.h"
+
+#define THREADS 8
+#define KEYS 20000
+
+typedef struct worker
+{
+    ltbs_cell **map;
+    ltbs_cell **keys;
+    Arena context;
+    int offset;
+} worker;
+
+// Every thread visits every key, starting at a different place, and
+// bumps its counter with a compare-and-swap retry loop.
+void *count_keys(void *param)
+{
+    worker *self = param;
+
+    for ( int step = 0; step < KEYS; step++ )
+    {
+	ltbs_cell *key = self->keys[(step + self->offset) % KEYS];
+	ltbs_cell *zero = List_Vt.from_int(0, &self->context);
+	ltbs_cell *current = Concurrent_Vt.insert(self->map, key, zero, &self->context);
+
+	for ( ;; )
+	{
+	    ltbs_cell *next = List_Vt.from_int(current->data.integer + 1, &self->context);
+
+	    if ( Concurrent_Vt.replace(self->map, key, current, next) )
+		break;
+
+	    current = Concurrent_Vt.lookup(self->map, key);
+	}
+    }
+
+    return 0;
+}
+
+void *overwrite_keys(void *param)
+{
+    worker *self = param;
+
+    for ( int step = 0; step < KEYS; step++ )
+	Concurrent_Vt.upsert(self->map, self->keys[step], List_Vt.from_int(self->offset, &self->context), &self->context);
+
+    return 0;
+}
+
+int run_workers(void *(*task)(void *), worker *workers)
+{
+    pthread_t threads[THREADS];
+
+    for ( int index = 0; index < THREADS; index++ )
+	if ( pthread_create(&threads[index], 0, task, &workers[index]) != 0 )
+	    return 0;
+
+    for ( int index = 0; index < THREADS; index++ )
+	pthread_join(threads[index], 0);
+
+    return 1;
+}
+
+int main()
+{
+    Arena context = {0};
+    ltbs_cell *map = Hash_Vt.new(&context);
+    ltbs_cell **keys = arena_alloc(&context, KEYS * sizeof(ltbs_cell *));
+    worker workers[THREADS];
+    int failures = 0;
+
+    for ( int index = 0; index < KEYS; index++ )
+	keys[index] = String_Vt.format(&context, "row-%d", index);
+
+    for ( int index = 0; index < THREADS; index++ )
+	workers[index] = (worker) { .map = &map, .keys = keys, .offset = index * (KEYS / THREADS) };
+
+    printf("Counting from %d threads\n", THREADS);
+    {
+	failures += !run_workers(count_keys, workers);
+
+	int wrong = 0;
+
+	for ( int index = 0; index < KEYS; index++ )
+	    if ( Hash_Vt.upsert(&map, keys[index], 0, 0)->data.integer != THREADS )
+		wrong++;
+
+	printf("entries %zu, wrong counts %d: %s\n",
+	       Hash_Vt.count(&map), wrong,
+	       (Hash_Vt.count(&map) == KEYS) && (wrong == 0) ? "PASS" : "FAIL");
+	failures += (Hash_Vt.count(&map) != KEYS) || (wrong != 0);
+    }
+
+    printf("Overwriting from %d threads\n", THREADS);
+    {
+	failures += !run_workers(overwrite_keys, workers);
+
+	int wrong = 0;
+
+	for ( int index = 0; index < KEYS; index++ )
+	{
+	    int64_t value = Concurrent_Vt.lookup(&map, keys[index])->data.integer;
+
+	    if ( (value < 0) || (value >= THREADS * (KEYS / THREADS)) || (value % (KEYS / THREADS) != 0) )
+		wrong++;
+	}
+
+	ltbs_cell *missing = String_Vt.cs("row-missing", &context);
+
+	printf("entries %zu, unexpected values %d, missing key absent %d: %s\n",
+	       Hash_Vt.count(&map), wrong, Concurrent_Vt.lookup(&map, missing) == 0,
+	       (wrong == 0) && (Hash_Vt.count(&map) == KEYS) ? "PASS" : "FAIL");
+	failures += (wrong != 0) || (Hash_Vt.count(&map) != KEYS);
+    }
+
+    printf("Maps built elsewhere\n");
+    {
+	// Parsed objects and plain Hash_Vt maps must read the same.
+	ltbs_json_status status;
+	ltbs_cell *parsed = Json_Vt.parse(String_Vt.cs("{\"alpha\":1,\"beta\":2}", &context), 0, &context, &status);
+	ltbs_cell *alpha = String_Vt.cs("alpha", &context);
+	ltbs_cell *found = Concurrent_Vt.lookup(&parsed, alpha);
+
+	Concurrent_Vt.upsert(&parsed, alpha, List_Vt.from_int(99, &context), &context);
+
+	int correct = (found != 0) && (found->data.integer == 1) && (Hash_Vt.count(&parsed) == 2) &&
+	    (Hash_Vt.lookup_view(&parsed, alpha)->data.integer == 99);
+
+	printf("parsed lookup %d, count after upsert %zu: %s\n",
+	       found != 0, Hash_Vt.count(&parsed), correct ? "PASS" : "FAIL");
+	failures += !correct;
+    }
+
+    for ( int index = 0; index < THREADS; index++ )
+	arena_free(&workers[index].context);
+
+    arena_free(&context);
+
+    return failures;
+}
@@ -19,17 +19,15 @@ int main()
 	.data = { .custom = { .data = buffer, .size = 10 } }
     };
 
-    int array_length = 15;
-    ltbs_cell *array_test = ltbs_alloc(&context);
-    array_test->type = LTBS_ARRAY;
-    array_test->data.array.length = array_length;
-    array_test->data.array.arrdata = arena_alloc(&context, sizeof(ltbs_cell) * array_length);
+    ltbs_cell *array_items = List_Vt.nil();
 
     {
-	for ( int index = -7; index < array_length; index++ )
-	    array_test->data.array.arrdata[index + 7] = int_from_int(index, &context);	
+	for ( int index = 7; index >= -7; index-- )
+	    array_items = pair_cons(int_from_int(index, &context), array_items, &context);
     }
 
+    ltbs_cell *array_test = Array_Vt.from_list(array_items, &context);
+
     ltbs_cell *list_test = ltbs_alloc(&context);
     list_test->type = LTBS_PAIR;
     list_test->data.pair = (ltbs_pair) {0};
@@ -70,6 +68,25 @@ int main()
     actual_test = format_string("{{hashmap_test}}", container, &context);
     string_print(actual_test);
     printf("\n\n");
+
+    actual_test = format_string("{{ int_test }} {{float_test}} {{byte_test}} {{missing}}| {{}} {{unterminated", hashmap_test, &context);
+    string_print(actual_test);
+    printf("\n\n");
+
+    {
+	ltbs_template_cache *cache = Template_Vt.cache_new(&context);
+	ltbs_template *compiled = Template_Vt.cache_get(cache, "<p>{{string_test}}: {{int_test}}</p>");
+
+	printf("cached: %d\n", compiled == Template_Vt.cache_get(cache, "<p>{{string_test}}: {{int_test}}</p>"));
+	printf("segments: %zu\n", compiled->count);
+
+	for ( int index = 0; index < 3; index++ )
+	{
+	    int_test.data.integer = index;
+	    string_print(Template_Vt.render(compiled, hashmap_test, &context));
+	    printf("\n");
+	}
+    }
     
     arena_free(&context);
 }
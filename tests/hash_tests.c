@@ -0,0 +1,247 @@
+#define ARENA_IMPLEMENTATION
+#define LIBBLACKSQUID_IMPLEMENTATION
+#include "../libblacksquid.h"
+#include <stdio.h>
+
+static uint64_t random_state = 0x2545F4914F6CDD1DULL;
+
+uint64_t next_random()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+uint64_t hash_of(const char *cstring)
+{
+    ltbs_string key = { .strdata = (byte *) cstring, .length = (unsigned int) strlen(cstring) };
+    return Hash_Vt.compute(&key);
+}
+
+int sort_hashes(const void *left, const void *right)
+{
+    uint64_t a = *(const uint64_t *) left;
+    uint64_t b = *(const uint64_t *) right;
+
+    return (a > b) - (a < b);
+}
+
+void trie_depths(ltbs_cell *node, size_t depth, size_t *total, size_t *deepest)
+{
+    if ( node == 0 )
+	return;
+
+    *total += depth;
+
+    if ( depth > *deepest )
+	*deepest = depth;
+
+    for ( int index = 0; index < 4; index++ )
+	trie_depths(node->data.hashmap.children[index], depth + 1, total, deepest);
+}
+
+int main()
+{
+    Arena context = {0};
+    int failures = 0;
+
+    printf("Short keys\n");
+    {
+	// Every printable key of one and two bytes must hash apart.
+	uint64_t *hashes = malloc(sizeof(uint64_t) * (95 + 95 * 95));
+	size_t count = 0;
+	size_t collisions = 0;
+	char key[3] = {0};
+
+	for ( int first = ' '; first <= '~'; first++ )
+	{
+	    key[0] = (char) first;
+	    key[1] = 0;
+	    hashes[count++] = hash_of(key);
+
+	    for ( int second = ' '; second <= '~'; second++ )
+	    {
+		key[1] = (char) second;
+		hashes[count++] = hash_of(key);
+	    }
+	}
+
+	qsort(hashes, count, sizeof(uint64_t), sort_hashes);
+
+	for ( size_t index = 1; index < count; index++ )
+	    collisions += hashes[index] == hashes[index - 1];
+
+	printf("\"AB\" %016llx, \"AC\" %016llx\n",
+	       (unsigned long long) hash_of("AB"), (unsigned long long) hash_of("AC"));
+	printf("%zu keys, %zu collisions: %s\n", count, collisions, collisions == 0 ? "PASS" : "FAIL");
+	failures += collisions != 0;
+	free(hashes);
+    }
+
+    printf("Avalanche\n");
+    {
+	// Flipping any input bit should flip every output bit half the time;
+	// with 4000 samples the noise alone reaches about 4%.
+	const size_t lengths[] = { 3, 8, 16, 31, 64, 100 };
+	const int samples = 4000;
+	double worst = 0;
+
+	for ( size_t which = 0; which < sizeof(lengths) / sizeof(lengths[0]); which++ )
+	{
+	    size_t length = lengths[which];
+	    size_t bits = length * 8;
+	    int *flips = calloc(bits * 64, sizeof(int));
+	    byte key[100];
+
+	    for ( int sample = 0; sample < samples; sample++ )
+	    {
+		for ( size_t index = 0; index < length; index++ )
+		    key[index] = (byte) next_random();
+
+		uint64_t original = Hash_Vt.bytes(key, length, LTBS_HASH_SEED);
+
+		for ( size_t bit = 0; bit < bits; bit++ )
+		{
+		    key[bit / 8] ^= (byte) (1 << (bit % 8));
+		    uint64_t changed = original ^ Hash_Vt.bytes(key, length, LTBS_HASH_SEED);
+		    key[bit / 8] ^= (byte) (1 << (bit % 8));
+
+		    for ( int out = 0; out < 64; out++ )
+			flips[bit * 64 + out] += (int) ((changed >> out) & 1);
+		}
+	    }
+
+	    double length_worst = 0;
+
+	    for ( size_t cell = 0; cell < bits * 64; cell++ )
+	    {
+		double bias = (double) flips[cell] / samples - 0.5;
+		bias = bias < 0 ? -bias : bias;
+
+		if ( bias > length_worst )
+		    length_worst = bias;
+	    }
+
+	    printf("length %3zu: worst bias %.2f%%\n", length, length_worst * 100);
+
+	    if ( length_worst > worst )
+		worst = length_worst;
+
+	    free(flips);
+	}
+
+	printf("worst bias under 5%%: %s\n", worst < 0.05 ? "PASS" : "FAIL");
+	failures += worst >= 0.05;
+    }
+
+    printf("Top bits of sequential keys\n");
+    {
+	// The trie branches on the top bits first, so they must be uniform.
+	size_t buckets[256] = {0};
+	const size_t keys = 1000000;
+	char key[32];
+
+	for ( size_t index = 0; index < keys; index++ )
+	{
+	    snprintf(key, sizeof(key), "key%zu", index);
+	    buckets[hash_of(key) >> 56]++;
+	}
+
+	double expected = (double) keys / 256;
+	double chi_squared = 0;
+
+	for ( int index = 0; index < 256; index++ )
+	{
+	    double difference = (double) buckets[index] - expected;
+	    chi_squared += difference * difference / expected;
+	}
+
+	// 255 degrees of freedom; 330 is the 0.1% tail.
+	printf("chi-squared %.1f: %s\n", chi_squared, chi_squared < 330 ? "PASS" : "FAIL");
+	failures += chi_squared >= 330;
+    }
+
+    printf("Trie depth\n");
+    {
+	ltbs_cell *map = Hash_Vt.new(&context);
+	const size_t keys = 100000;
+	size_t total = 0;
+	size_t deepest = 0;
+	char key[32];
+
+	for ( size_t index = 0; index < keys; index++ )
+	{
+	    snprintf(key, sizeof(key), "key%zu", index);
+	    Hash_Vt.upsert(&map, String_Vt.cs(key, &context), List_Vt.from_int((int64_t) index, &context), &context);
+	}
+
+	trie_depths(map, 0, &total, &deepest);
+
+	// A uniform hash gives about log4(n) + 1, near 9.3 here.
+	double average = (double) total / (double) (keys + 1);
+	printf("average depth %.2f, deepest %zu: %s\n", average, deepest, average < 11 ? "PASS" : "FAIL");
+	failures += average >= 11;
+    }
+
+    printf("Sequential integer keys\n");
+    {
+	// Row IDs are dense, and the trie reads the top bits while the
+	// flat map tags slots with the low seven.
+	size_t top[256] = {0};
+	size_t low[128] = {0};
+	const size_t keys = 1000000;
+	ltbs_cell *map = Hash_Vt.new(&context);
+	size_t total = 0;
+	size_t deepest = 0;
+
+	for ( uint64_t index = 0; index < keys; index++ )
+	{
+	    uint64_t hash = Hash_Vt.mix64(index);
+	    top[hash >> 56]++;
+	    low[hash & 0x7F]++;
+	}
+
+	double top_chi = 0;
+	double low_chi = 0;
+
+	for ( int index = 0; index < 256; index++ )
+	{
+	    double difference = (double) top[index] - (double) keys / 256;
+	    top_chi += difference * difference / ((double) keys / 256);
+	}
+
+	for ( int index = 0; index < 128; index++ )
+	{
+	    double difference = (double) low[index] - (double) keys / 128;
+	    low_chi += difference * difference / ((double) keys / 128);
+	}
+
+	for ( int64_t index = 0; index < 100000; index++ )
+	    Hash_Vt.upsert_int(&map, index, map, &context);
+
+	trie_depths(map, 0, &total, &deepest);
+
+	// 127 degrees of freedom; 181 is the 0.1% tail.
+	double average = (double) total / 100001.0;
+	int passed = (top_chi < 330) && (low_chi < 181) && (average < 11);
+
+	printf("chi-squared top %.1f, low %.1f, average depth %.2f: %s\n",
+	       top_chi, low_chi, average, passed ? "PASS" : "FAIL");
+	failures += !passed;
+    }
+
+    printf("Seeds and case folding\n");
+    {
+	ltbs_string mixed = { .strdata = "Stop Words", .length = 10 };
+	ltbs_string upper = { .strdata = "STOP WORDS", .length = 10 };
+	int seeds_differ = Hash_Vt.bytes("key", 3, 1) != Hash_Vt.bytes("key", 3, 2);
+	int nocase_matches = Hash_Vt.compute_nocase(&mixed) == Hash_Vt.compute(&upper);
+
+	printf("seeds differ: %d, nocase matches upcase: %d\n", seeds_differ, nocase_matches);
+	failures += !seeds_differ || !nocase_matches;
+    }
+
+    arena_free(&context);
+    return failures;
+}
@@ -224,6 +224,40 @@ int main()
     printf("Actual count: %d\n", count);
     printf("Keys count: %d\n", List_Vt.count(keys));
 
+    printf("\n----------------\n");
+    printf("PROBE START");
+    printf("\n----------------\n");
+    {
+	// One in-place pass upcases the whole text, then every token is
+	// trimmed and probed as a view without being copied.
+	ltbs_cell *text = String_Vt.cs(
+	    "  The quick brown fox didn't jump over\tthe lazy dog; "
+	    "it was already there\n and nobody Knew why  ",
+	    context
+	);
+	ltbs_split_iter iter = String_Vt.split_iter(text, ' ');
+	ltbs_cell token;
+	int hits = 0;
+
+	String_Vt.upcase_in_place(text);
+
+	while ( String_Vt.split_next(&iter, &token) )
+	{
+	    String_Vt.trim(&token, &token);
+
+	    if ( token.data.string.length && Hash_Vt.upsert(&hashmap, &token, 0, 0) )
+	    {
+		printf("%.*s, ", (int) token.data.string.length, token.data.string.strdata);
+		hits++;
+	    }
+	}
+
+	printf("\nStop words found: %d\n", hits);
+    }
+    printf("\n----------------\n");
+    printf("PROBE END");
+    printf("\n----------------\n");
+
     arena_free(context);
     free(context);
     return 0;
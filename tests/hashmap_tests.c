@@ -5,6 +5,11 @@
 #define LIBBLACKSQUID_IMPLEMENTATION
 #include "../libblacksquid.h"
 
+void sum_entry(ltbs_cell *key, ltbs_cell *value, void *param)
+{
+    *(int64_t *) param += value->data.integer;
+}
+
 int main ()
 {
     Arena context = {0};
@@ -74,6 +79,362 @@ int main ()
 	printf(")\n");
     }
 
+    {
+	printf("\n\nInterning\n\n");
+
+	ltbs_intern_table *symbols = Intern_Vt.new(&context);
+	ltbs_cell *foo = Intern_Vt.cs(symbols, "foo");
+	ltbs_cell *bar = Intern_Vt.cs(symbols, "bar");
+	ltbs_cell *foo_again = Intern_Vt.intern(symbols, String_Vt.cs("foo", &context));
+	ltbs_cell *foo_bytes = Intern_Vt.bytes(symbols, (byte *) "foobar", 3);
+
+	printf("foo == foo: %d\n", foo == foo_again);
+	printf("foo == foo (bytes): %d\n", foo == foo_bytes);
+	printf("foo == bar: %d\n", foo == bar);
+	printf("compare(foo, bar): %d\n", String_Vt.compare(foo, bar));
+	printf("compare(foo, \"foo\"): %d\n",
+	       String_Vt.compare(foo, String_Vt.cs("foo", &context)));
+	printf("symbols: %zu\n", Intern_Vt.count(symbols));
+
+	ltbs_cell *hashmap = Hash_Vt.new(&context);
+	Hash_Vt.upsert(&hashmap, foo, int_from_int(1, &context), &context);
+	printf("'foo' via symbol: %d\n", Hash_Vt.upsert(&hashmap, foo_again, 0, 0)->data.integer);
+	printf("'foo' via lookup: %d\n", Hash_Vt.lookup(&hashmap, "foo")->data.integer);
+    }
+
+    {
+	printf("\n\nAllocation-free lookups\n\n");
+
+	ltbs_cell *hashmap = Hash_Vt.new(&context);
+	ltbs_cell *line = String_Vt.cs("alpha beta gamma", &context);
+	ltbs_cell *beta = String_Vt.cs("beta", &context);
+	ltbs_split_iter words = String_Vt.split_iter(line, ' ');
+	ltbs_cell view = {0};
+
+	Hash_Vt.upsert(&hashmap, String_Vt.cs("alpha", &context), int_from_int(1, &context), &context);
+	Hash_Vt.adopt(&hashmap, beta, int_from_int(2, &context), &context);
+
+	String_Vt.split_next(&words, &view);
+	String_Vt.split_next(&words, &view);
+	printf("'beta' (view): %d\n", Hash_Vt.lookup_view(&hashmap, &view)->data.integer);
+
+	String_Vt.split_next(&words, &view);
+	Hash_Vt.adopt(&hashmap, String_Vt.copy(&view, &context), int_from_int(3, &context), &context);
+
+	printf("'alpha' (bytes): %d\n", Hash_Vt.lookup_bytes(&hashmap, "alpha beta", 5)->data.integer);
+	printf("'gamma' (hashed): %d\n",
+	       Hash_Vt.lookup_hashed(
+		   &hashmap, "gamma", 5,
+		   Hash_Vt.bytes("gamma", 5, LTBS_HASH_SEED)
+	       )->data.integer);
+	printf("'beta' adopted: %d\n", Hash_Vt.upsert(&hashmap, beta, 0, 0) != 0);
+	printf("'delta' missing: %d\n", Hash_Vt.lookup_bytes(&hashmap, "delta", 5) == 0);
+	printf("'alph' missing: %d\n", Hash_Vt.lookup_bytes(&hashmap, "alpha", 4) == 0);
+    }
+
+    {
+	printf("\n\nRemoval\n\n");
+
+	ltbs_cell *hashmap = Hash_Vt.new(&context);
+	ltbs_cell *keys[1000];
+	int missing = 0;
+	int wrong = 0;
+
+	for ( int index = 0; index < 1000; index++ )
+	{
+	    keys[index] = String_Vt.format(&context, "key-%d", index);
+	    Hash_Vt.upsert(&hashmap, keys[index], int_from_int(index, &context), &context);
+	}
+
+	Hash_Vt.upsert(&hashmap, keys[7], int_from_int(7, &context), &context);
+	printf("count after insert: %zu\n", Hash_Vt.count(&hashmap));
+
+	for ( int index = 0; index < 1000; index += 2 )
+	    if ( Hash_Vt.remove(&hashmap, keys[index])->data.integer != index )
+		wrong++;
+
+	printf("count after removing evens: %zu\n", Hash_Vt.count(&hashmap));
+	printf("removing again: %d\n", Hash_Vt.remove(&hashmap, keys[0]) == 0);
+
+	for ( int index = 0; index < 1000; index++ )
+	{
+	    ltbs_cell *found = Hash_Vt.upsert(&hashmap, keys[index], 0, 0);
+
+	    if ( (index % 2 == 0) && (found != 0) ) wrong++;
+	    if ( (index % 2 == 1) && (found == 0) ) missing++;
+	    if ( (found != 0) && (found->data.integer != index) ) wrong++;
+	}
+
+	printf("missing: %d, wrong: %d\n", missing, wrong);
+	printf("keys listed: %u\n", List_Vt.count(Hash_Vt.keys(&hashmap, &context)));
+
+	Hash_Vt.clear(&hashmap);
+	printf("count after clear: %zu\n", Hash_Vt.count(&hashmap));
+	printf("'key-1' after clear: %d\n", Hash_Vt.lookup(&hashmap, "key-1") == 0);
+
+	Hash_Vt.upsert(&hashmap, keys[1], int_from_int(1, &context), &context);
+	printf("count after reuse: %zu\n", Hash_Vt.count(&hashmap));
+
+	ltbs_cell *lazy = 0;
+	Hash_Vt.clear(&lazy);
+	printf("null map: count %zu, remove %d\n", Hash_Vt.count(&lazy), Hash_Vt.remove(&lazy, keys[1]) == 0);
+
+	for ( int index = 0; index < 10; index++ )
+	    Hash_Vt.upsert(&lazy, keys[index], int_from_int(index, &context), &context);
+
+	printf("null map after inserts: count %zu, 'key-9': %d, root holds no key: %d\n",
+	       Hash_Vt.count(&lazy), (int) Hash_Vt.lookup(&lazy, "key-9")->data.integer,
+	       lazy->data.hashmap.key == 0);
+    }
+
+    {
+	printf("\n\nFlat map\n\n");
+
+	ltbs_cell *trie = Hash_Vt.new(&context);
+	ltbs_cell *flat = Flat_Vt.new(0, &context);
+	ltbs_cell *keys[3000];
+	int mismatches = 0;
+
+	srand(1234);
+
+	for ( int index = 0; index < 3000; index++ )
+	    keys[index] = String_Vt.format(&context, "id-%d", rand() % 2000);
+
+	for ( int round = 0; round < 30000; round++ )
+	{
+	    ltbs_cell *key = keys[rand() % 3000];
+
+	    switch ( rand() % 3 )
+	    {
+		case 0:
+		{
+		    ltbs_cell *value = int_from_int(round, &context);
+		    Hash_Vt.upsert(&trie, key, value, &context);
+		    Hash_Vt.upsert(&flat, key, value, &context);
+		}
+		break;
+
+		case 1:
+		    if ( Hash_Vt.remove(&trie, key) != Hash_Vt.remove(&flat, key) )
+			mismatches++;
+		    break;
+
+		default:
+		    if ( Hash_Vt.lookup_view(&trie, key) != Hash_Vt.lookup_view(&flat, key) )
+			mismatches++;
+	    }
+	}
+
+	printf("mismatches against the trie: %d\n", mismatches);
+	printf("same count: %d\n", Hash_Vt.count(&trie) == Hash_Vt.count(&flat));
+	printf("keys listed: %d\n", List_Vt.count(Hash_Vt.keys(&flat, &context)) == Hash_Vt.count(&flat));
+
+	Flat_Vt.reserve(&flat, 10000, &context);
+	printf("lookup after reserve: %d\n",
+	       Hash_Vt.lookup_view(&trie, keys[0]) == Hash_Vt.lookup_view(&flat, keys[0]));
+
+	Hash_Vt.clear(&flat);
+	Hash_Vt.upsert(&flat, String_Vt.cs("hello", &context), int_from_int(42, &context), &context);
+	printf("'hello' after clear: %d\n", Hash_Vt.lookup(&flat, "hello")->data.integer);
+	printf("count after clear: %zu\n", Hash_Vt.count(&flat));
+
+	ltbs_cell *none = 0;
+	ltbs_hash_iter iter = Hash_Vt.iter(&none);
+	printf("null map reads as empty: %d\n",
+	       (Hash_Vt.lookup(&none, "hello") == 0) &&
+	       (Hash_Vt.lookup_int(&none, 7) == 0) &&
+	       (Hash_Vt.next(&iter, 0, 0) == 0) &&
+	       (pair_head(Hash_Vt.keys(&none, &context)) == 0) &&
+	       (none == 0));
+    }
+
+    {
+	printf("\n\nInteger and byte keys\n\n");
+
+	ltbs_cell *maps[2] = { Hash_Vt.new(&context), Flat_Vt.new(0, &context) };
+
+	for ( int which = 0; which < 2; which++ )
+	{
+	    ltbs_cell **map = &maps[which];
+	    int wrong = 0;
+
+	    for ( int64_t row = -500; row < 500; row++ )
+		Hash_Vt.upsert_int(map, row * 1000003, int_from_int(row, &context), &context);
+
+	    for ( int64_t row = -500; row < 500; row += 2 )
+		Hash_Vt.remove_int(map, row * 1000003);
+
+	    for ( int64_t row = -500; row < 500; row++ )
+	    {
+		ltbs_cell *found = Hash_Vt.lookup_int(map, row * 1000003);
+
+		if ( (row % 2 == 0) != (found == 0) ) wrong++;
+		if ( (found != 0) && (found->data.integer != row) ) wrong++;
+	    }
+
+	    ltbs_cell *first = List_Vt.head(Hash_Vt.keys(map, &context));
+
+	    printf("%s: count %zu, wrong %d, key round trip %d, uint alias %d\n",
+		   which ? "flat" : "trie",
+		   Hash_Vt.count(map),
+		   wrong,
+		   Hash_Vt.lookup_int(map, Hash_Vt.key_int(first)) != 0,
+		   Hash_Vt.lookup_uint(map, (uint64_t) -499 * 1000003) != 0);
+	}
+
+	struct { uint32_t table; uint32_t column; } cell_id = { 7, 3 };
+	ltbs_cell *bytes_map = Flat_Vt.new(16, &context);
+
+	Hash_Vt.upsert_bytes(&bytes_map, &cell_id, sizeof(cell_id), int_from_int(73, &context), &context);
+	printf("struct key: %d\n",
+	       Hash_Vt.lookup_bytes(&bytes_map, (const byte *) &cell_id, sizeof(cell_id))->data.integer);
+	cell_id.column = 4;
+	printf("other struct key missing: %d\n",
+	       Hash_Vt.lookup_bytes(&bytes_map, (const byte *) &cell_id, sizeof(cell_id)) == 0);
+	cell_id.column = 3;
+	printf("struct key removed: %d\n",
+	       Hash_Vt.remove_bytes(&bytes_map, &cell_id, sizeof(cell_id))->data.integer);
+    }
+
+    {
+	printf("\n\nIterators\n\n");
+
+	ltbs_cell *maps[2] = { Hash_Vt.new(&context), Flat_Vt.new(0, &context) };
+	const int64_t entries = 100000;
+
+	for ( int which = 0; which < 2; which++ )
+	{
+	    ltbs_cell **map = &maps[which];
+	    int64_t expected = 0;
+
+	    for ( int64_t row = 0; row < entries; row++ )
+	    {
+		Hash_Vt.upsert_int(map, row, int_from_int(row * 3, &context), &context);
+		expected += row * 3;
+	    }
+
+	    ltbs_hash_iter iter = Hash_Vt.iter(map);
+	    ltbs_cell *key;
+	    ltbs_cell *value;
+	    int64_t seen = 0;
+	    int64_t sum = 0;
+	    int64_t for_each_sum = 0;
+	    int wrong = 0;
+
+	    while ( Hash_Vt.next(&iter, &key, &value) )
+	    {
+		seen++;
+		sum += value->data.integer;
+		wrong += value->data.integer != Hash_Vt.key_int(key) * 3;
+	    }
+
+	    Hash_Vt.for_each(map, sum_entry, &for_each_sum);
+
+	    ltbs_cell *first = List_Vt.head(Hash_Vt.entries(map, &context));
+
+	    printf("%s: seen %d, sums match %d, wrong %d, values %u, entry pair %d, done stays done %d\n",
+		   which ? "flat" : "trie",
+		   seen == entries,
+		   (sum == expected) && (for_each_sum == expected),
+		   wrong,
+		   List_Vt.count(Hash_Vt.values(map, &context)),
+		   Hash_Vt.lookup_int(map, Hash_Vt.key_int(first->data.pair.head)) == first->data.pair.rest,
+		   Hash_Vt.next(&iter, 0, 0) == 0);
+	}
+
+	ltbs_cell *empty = Hash_Vt.new(&context);
+	ltbs_hash_iter none = Hash_Vt.iter(&empty);
+	printf("empty map has no entries: %d\n", Hash_Vt.next(&none, 0, 0) == 0);
+    }
+
+    {
+	printf("\n\nPersistent updates\n\n");
+
+	// Every version is kept, along with what it should contain.
+	enum { KEYS = 300, VERSIONS = 3000 };
+	ltbs_cell *keys[KEYS];
+	ltbs_cell **versions = malloc(sizeof(ltbs_cell *) * (VERSIONS + 1));
+	int *expected = calloc((size_t) (VERSIONS + 1) * KEYS, sizeof(int));
+	int mismatches = 0;
+	int counts_wrong = 0;
+
+	srand(4321);
+
+	for ( int index = 0; index < KEYS; index++ )
+	    keys[index] = String_Vt.format(&context, "setting-%d", index);
+
+	versions[0] = Hash_Vt.new(&context);
+
+	for ( int version = 1; version <= VERSIONS; version++ )
+	{
+	    int key = rand() % KEYS;
+	    int *now = &expected[version * KEYS];
+
+	    memcpy(now, &expected[(version - 1) * KEYS], sizeof(int) * KEYS);
+
+	    if ( rand() % 3 == 0 )
+	    {
+		versions[version] = Persistent_Vt.remove(versions[version - 1], keys[key], &context);
+		now[key] = 0;
+	    }
+
+	    else
+	    {
+		versions[version] = Persistent_Vt.upsert(versions[version - 1], keys[key], int_from_int(version, &context), &context);
+		now[key] = version;
+	    }
+	}
+
+	for ( int version = 0; version <= VERSIONS; version++ )
+	{
+	    size_t present = 0;
+
+	    for ( int key = 0; key < KEYS; key++ )
+	    {
+		ltbs_cell *found = Hash_Vt.lookup_view(&versions[version], keys[key]);
+		int want = expected[version * KEYS + key];
+
+		present += want != 0;
+
+		if ( (found == 0) != (want == 0) ) mismatches++;
+		else if ( (found != 0) && (found->data.integer != want) ) mismatches++;
+	    }
+
+	    counts_wrong += Hash_Vt.count(&versions[version]) != present;
+	}
+
+	ltbs_cell *latest = versions[VERSIONS];
+	ltbs_cell *value = Hash_Vt.lookup_view(&latest, keys[0]);
+
+	printf("snapshot mismatches: %d, wrong counts: %d\n", mismatches, counts_wrong);
+	printf("removing a missing key keeps the root: %d\n",
+	       Persistent_Vt.remove(latest, String_Vt.cs("absent", &context), &context) == latest);
+	printf("storing the same value keeps the root: %d\n",
+	       (value == 0) || (Persistent_Vt.upsert(latest, keys[0], value, &context) == latest));
+	printf("empty snapshot untouched: %zu\n", Hash_Vt.count(&versions[0]));
+
+	// Parsed objects adopt their keys, so they must match like any other.
+	ltbs_json_status status;
+	ltbs_cell *parsed = Json_Vt.parse(String_Vt.cs("{\"alpha\":1,\"beta\":2}", &context), 0, &context, &status);
+	ltbs_cell *alpha = String_Vt.cs("alpha", &context);
+	ltbs_cell *updated = Persistent_Vt.upsert(parsed, alpha, int_from_int(99, &context), &context);
+	ltbs_cell *removed = Persistent_Vt.remove(parsed, alpha, &context);
+
+	printf("parsed object: upsert count %zu value %lld, remove count %zu, original count %zu\n",
+	       Hash_Vt.count(&updated), (long long) Hash_Vt.lookup_view(&updated, alpha)->data.integer,
+	       Hash_Vt.count(&removed), Hash_Vt.count(&parsed));
+
+	ltbs_cell *from_null = Persistent_Vt.upsert(0, alpha, int_from_int(1, &context), &context);
+	ltbs_cell *flat = Flat_Vt.new(0, &context);
+
+	printf("null map upsert count %zu, remove on null %d, flat map refused %d\n",
+	       Hash_Vt.count(&from_null), Persistent_Vt.remove(0, alpha, &context) == 0,
+	       Persistent_Vt.upsert(flat, alpha, int_from_int(1, &context), &context) == 0);
+
+	free(expected);
+	free(versions);
+    }
+
     arena_free(&context);
     
     return 0;
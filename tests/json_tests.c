@@ -0,0 +1,145 @@
+#define ARENA_IMPLEMENTATION
+#define LIBBLACKSQUID_IMPLEMENTATION
+#include "../libblacksquid.h"
+#include <stdio.h>
+#include <unistd.h>
+
+int main()
+{
+    Arena context = {0};
+
+    printf("Serializing to JSON...\n");
+    {
+	ltbs_cell *numbers = List_Vt.nil();
+	ltbs_cell *empty = ltbs_alloc(&context);
+	*empty = *List_Vt.nil();
+
+	for ( int index = 3; index > 0; index-- )
+	    numbers = List_Vt.cons(int_from_int(index, &context), numbers, &context);
+
+	ltbs_cell *inner;
+	hashmap_from_kvps(
+	    inner, &context,
+	    {"zeta", List_Vt.from_float(0.5, &context)},
+	    {"alpha", List_Vt.from_uint(18446744073709551615u, &context)}
+	);
+
+	unsigned char raw[3] = { 0xde, 0xad, 0x01 };
+	ltbs_cell custom = (ltbs_cell)
+	{
+	    .type = LTBS_CUSTOM,
+	    .data = { .custom = { .data = raw, .size = sizeof(raw) } }
+	};
+
+	ltbs_cell *document;
+	hashmap_from_kvps(
+	    document, &context,
+	    {"name", String_Vt.cs("quote \" backslash \\ tab \t bell \a caf\xc3\xa9 and a longer tail", &context)},
+	    {"numbers", numbers},
+	    {"cells", Array_Vt.from_list(numbers, &context)},
+	    {"empty", empty},
+	    {"missing", List_Vt.nil()},
+	    {"inner", inner},
+	    {"raw", &custom}
+	);
+
+	String_Vt.print(format_serialize(0, document, &context));
+	printf("\n");
+	String_Vt.print(Json_Vt.serialize(document, LTBS_JSON_CANONICAL, &context));
+	printf("\n");
+	String_Vt.print(format_serialize("pretty canonical", document, &context));
+	printf("\n");
+
+	fflush(stdout);
+	int status = Json_Vt.write_fd(STDOUT_FILENO, numbers, 0, &context);
+	printf("\nwrite_fd: %d\n", status);
+    }
+
+    printf("Serializing bytes...\n");
+    {
+	// Bytes of UTF-8 text are above 0x7F and must not sign-extend.
+	String_Vt.print(Json_Vt.serialize(String_Vt.to_list(String_Vt.cs("a\xc3\xa9", &context), &context), 0, &context));
+	printf("\n");
+    }
+
+    printf("Serializing integer keys...\n");
+    {
+	ltbs_cell *by_id = 0;
+
+	Hash_Vt.upsert_int(&by_id, -7, String_Vt.cs("negative", &context), &context);
+	Hash_Vt.upsert_int(&by_id, 250, String_Vt.cs("wide", &context), &context);
+	Hash_Vt.upsert_int(&by_id, 3, String_Vt.cs("small", &context), &context);
+	Hash_Vt.upsert_uint(&by_id, 18446744073709551615u, String_Vt.cs("largest", &context), &context);
+
+	String_Vt.print(Json_Vt.serialize(by_id, LTBS_JSON_CANONICAL, &context));
+	printf("\n");
+
+	ltbs_string_builder builder = Builder_Vt.new(0, &context);
+	Template_Vt.append_value(&builder, by_id);
+	String_Vt.print(Builder_Vt.finish(&builder));
+	printf("\n");
+    }
+
+    printf("Serializing deeply nested lists...\n");
+    {
+	ltbs_cell *nested = List_Vt.cons(int_from_int(0, &context), List_Vt.nil(), &context);
+
+	for ( int depth = 0; depth < 100000; depth++ )
+	    nested = List_Vt.cons(nested, List_Vt.nil(), &context);
+
+	ltbs_cell *serialized = Json_Vt.serialize(nested, 0, &context);
+	printf("length: %u\n", serialized->data.string.length);
+    }
+
+    printf("Parsing JSON...\n");
+    {
+	ltbs_cell *text = String_Vt.cs(
+	    "{\"name\": \"plain\", \"escaped\": \"tab\\there \\u00e9 \\ud83d\\ude00\", "
+	    "\"list\": [1, -2, 3.5, 1e3, true, false, null, [], {}], "
+	    "\"big\": 18446744073709551615, \"none\": null, \"nested\": {\"a\": {\"b\": [\"deep\"]}}}",
+	    &context
+	);
+	ltbs_json_status status;
+	ltbs_cell *parsed = Json_Vt.parse(text, 0, &context, &status);
+
+	printf("ok: %d\n", status.ok);
+	String_Vt.print(Json_Vt.serialize(parsed, LTBS_JSON_CANONICAL, &context));
+	printf("\n");
+
+	ltbs_cell *name = Hash_Vt.lookup(&parsed, "name");
+	printf("zero-copy name: %d\n",
+	       (name->data.string.strdata > text->data.string.strdata) &&
+	       (name->data.string.strdata < text->data.string.strdata + text->data.string.length));
+	printf("null is pair_nil(): %d\n",
+	       Hash_Vt.lookup(&parsed, "none") == List_Vt.nil());
+
+	ltbs_cell *as_arrays = Json_Vt.parse(String_Vt.cs("[[1, 2], [3]]", &context), LTBS_JSON_ARRAYS, &context, 0);
+	printf("array type: %d, elements: %zu\n", as_arrays->type == LTBS_ARRAY,
+	       as_arrays->data.array.total_size / as_arrays->data.array.elem_size);
+	String_Vt.print(Json_Vt.serialize(as_arrays, 0, &context));
+	printf("\n");
+
+	const char *invalid[] = { "[1, 2", "{\"a\" 1}", "[01]", "\"open", "[1] 2", "{\"a\": tru}", "[\"\\ud800\"]" };
+
+	for ( size_t index = 0; index < sizeof(invalid) / sizeof(invalid[0]); index++ )
+	{
+	    ltbs_cell *result = Json_Vt.parse(String_Vt.cs(invalid[index], &context), 0, &context, &status);
+	    printf("%-14s -> %s at %zu: %s\n", invalid[index], result ? "parsed" : "error", status.offset, status.message);
+	}
+    }
+
+    {
+	ltbs_cell *flat = Flat_Vt.new(4, &context);
+
+	Hash_Vt.upsert(&flat, String_Vt.cs("b", &context), int_from_int(2, &context), &context);
+	Hash_Vt.upsert(&flat, String_Vt.cs("a", &context), String_Vt.cs("one", &context), &context);
+	Hash_Vt.upsert(&flat, String_Vt.cs("c", &context), List_Vt.nil(), &context);
+
+	printf("flat map: ");
+	String_Vt.print(Json_Vt.serialize(flat, LTBS_JSON_CANONICAL, &context));
+	printf("\n");
+    }
+
+    arena_free(&context);
+    return 0;
+}
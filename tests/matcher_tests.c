@@ -0,0 +1,105 @@
+#define ARENA_IMPLEMENTATION
+#define LIBBLACKSQUID_IMPLEMENTATION
+#include "../libblacksquid.h"
+#include <stdio.h>
+
+const char *KEYWORDS[] = { "HE", "SHE", "HIS", "HERS", "SHE'S", "DON'T", "THE", 0 };
+
+void print_match(size_t pattern, size_t start, size_t end, void *param)
+{
+    const char *text = param;
+    printf("  %s at [%zu, %zu): %.*s\n", KEYWORDS[pattern], start, end, (int) (end - start), &text[start]);
+}
+
+void count_match(size_t pattern, size_t start, size_t end, void *param)
+{
+    size_t *counts = param;
+    counts[pattern]++;
+}
+
+int main()
+{
+    Arena context = {0};
+    ltbs_cell *patterns = List_Vt.nil();
+
+    for ( int index = 6; index >= 0; index-- )
+	patterns = List_Vt.cons(String_Vt.cs(KEYWORDS[index], &context), patterns, &context);
+
+    printf("Overlapping matches\n");
+    {
+	ltbs_matcher *matcher = Matcher_Vt.compile(patterns, 0, &context);
+	const char *text = "USHERS";
+	ltbs_cell *string = String_Vt.cs(text, &context);
+
+	printf("states: %u, classes: %u\n", matcher->state_count, matcher->class_count);
+	printf("found: %zu\n", Matcher_Vt.find_all(matcher, string, print_match, (void *) text));
+    }
+
+    printf("Case-insensitive whole words\n");
+    {
+	ltbs_matcher *matcher = Matcher_Vt.compile(patterns, LTBS_MATCH_NOCASE | LTBS_MATCH_WHOLE_WORDS, &context);
+	const char *text = "She said she's the one; he, the other, shears his sheep. Don't theorize.";
+	ltbs_cell *string = String_Vt.cs(text, &context);
+
+	printf("found: %zu\n", Matcher_Vt.find_all(matcher, string, print_match, (void *) text));
+    }
+
+    printf("Streaming in chunks\n");
+    {
+	ltbs_matcher *matcher = Matcher_Vt.compile(patterns, LTBS_MATCH_NOCASE | LTBS_MATCH_WHOLE_WORDS, &context);
+	const char *text = "the theme of the thesis: she shed hers, then he said the end, the";
+	size_t length = strlen(text);
+	size_t whole[7] = {0};
+	size_t chunked[7] = {0};
+
+	Matcher_Vt.find_all(matcher, String_Vt.cs(text, &context), count_match, whole);
+
+	// Chunks of three split words and matches across feeds.
+	ltbs_match_stream stream = Matcher_Vt.stream(matcher);
+
+	for ( size_t start = 0; start < length; start += 3 )
+	    Matcher_Vt.feed(&stream, &text[start], length - start < 3 ? length - start : 3, count_match, chunked);
+
+	Matcher_Vt.finish(&stream, count_match, chunked);
+
+	for ( int index = 0; KEYWORDS[index]; index++ )
+	    printf("  %s: %zu %zu\n", KEYWORDS[index], whole[index], chunked[index]);
+
+	// A finished stream starts over, so positions are within the new input.
+	const char *again = "so she said";
+
+	Matcher_Vt.feed(&stream, again, strlen(again), print_match, (void *) again);
+	Matcher_Vt.finish(&stream, print_match, (void *) again);
+    }
+
+    printf("Stop words in a file\n");
+    {
+	ltbs_cell *stop_words = List_Vt.nil();
+	const char *words[] = { "THE", "AND", "OF", "TO", "A", "IN", "FOR", "IS", "ON", "WITH", 0 };
+	size_t counts[10] = {0};
+
+	for ( int index = 9; index >= 0; index-- )
+	    stop_words = List_Vt.cons(String_Vt.cs(words[index], &context), stop_words, &context);
+
+	ltbs_matcher *matcher = Matcher_Vt.compile(stop_words, LTBS_MATCH_NOCASE | LTBS_MATCH_WHOLE_WORDS, &context);
+	ltbs_file_reader *reader = Reader_Vt.open("test_data/rss.htm", 4096, &context);
+	ltbs_match_stream stream = Matcher_Vt.stream(matcher);
+	ltbs_cell chunk;
+	size_t total = 0;
+
+	while ( Reader_Vt.next_chunk(reader, &chunk) )
+	    total += Matcher_Vt.feed(&stream, chunk.data.string.strdata, chunk.data.string.length, count_match, counts);
+
+	total += Matcher_Vt.finish(&stream, count_match, counts);
+	Reader_Vt.close(reader);
+
+	ltbs_cell *whole_file = String_Vt.from_file("test_data/rss.htm", &context);
+	printf("streamed: %zu, in one pass: %zu\n", total, Matcher_Vt.find_all(matcher, whole_file, 0, 0));
+
+	for ( int index = 0; words[index]; index++ )
+	    printf("  %s: %zu\n", words[index], counts[index]);
+    }
+
+    arena_free(&context);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#define LIBBLACKSQUID_IMPLEMENTATION
+#include "../libblacksquid.h"
+
+void print_chunk(const byte *chunk, size_t length, void *param)
+{
+    int *count = param;
+    printf("chunk %d: \"%.*s\"\n", (*count)++, (int) length, chunk);
+}
+
+int main()
+{
+    Arena context = {0};
+
+    ltbs_cell *hello = Rope_Vt.from_string(String_Vt.cs("Hello world!", &context), &context);
+    ltbs_cell *greeting = Rope_Vt.from_string(String_Vt.cs(" Ohayou Minna!", &context), &context);
+    ltbs_cell *rope = Rope_Vt.concat(hello, greeting, &context);
+
+    printf("concat: ");
+    String_Vt.print(Rope_Vt.flatten(rope, &context));
+    printf(" (length %zu)\n", Rope_Vt.length(rope));
+
+    rope = Rope_Vt.insert(rope, 5, Rope_Vt.from_string(String_Vt.cs(", cruel", &context), &context), &context);
+    printf("insert: ");
+    String_Vt.print(Rope_Vt.flatten(rope, &context));
+    printf("\n");
+
+    printf("substring(7, 12): ");
+    String_Vt.print(Rope_Vt.flatten(Rope_Vt.substring(rope, 7, 12, &context), &context));
+    printf("\n");
+
+    printf("remove(5, 12): ");
+    String_Vt.print(Rope_Vt.flatten(Rope_Vt.remove(rope, 5, 12, &context), &context));
+    printf("\n");
+
+    printf("at_index(4): %c\n", Rope_Vt.at_index(rope, 4));
+
+    ltbs_cell *from_file = String_Vt.from_file("test_data/rss.htm", &context);
+
+    if ( from_file )
+    {
+	ltbs_cell *document = Rope_Vt.from_string(from_file, &context);
+	ltbs_cell *marker = Rope_Vt.from_string(String_Vt.cs("<!-- patched -->", &context), &context);
+	size_t length = Rope_Vt.length(document);
+
+	for ( size_t index = 0; index < 64; index++ )
+	    document = Rope_Vt.insert(document, (index * 7919) % length, marker, &context);
+
+	int count = 0;
+	Rope_Vt.for_each(Rope_Vt.substring(document, 0, 200, &context), print_chunk, &count);
+
+	printf("patched length: %zu, height: %u\n", Rope_Vt.length(document), document->data.rope.height);
+    }
+
+    else printf("unable to read file.\n");
+
+    arena_free(&context);
+    return 0;
+}
@@ -57,8 +57,265 @@ int main()
     });
     printf(") \n");
 
+    printf("\n (");
+    {
+	ltbs_split_iter iter = String_Vt.split_iter(String_Vt.cs("a,,b,", &context), ',');
+	ltbs_cell token;
+
+	while ( String_Vt.split_next(&iter, &token) )
+	{
+	    printf("\"");
+	    String_Vt.print(&token);
+	    printf("\", ");
+	}
+    }
+    printf(") \n");
+
+    {
+	ltbs_cell *tokens = String_Vt.split_collect(
+	    String_Vt.split_multi_iter(
+		String_Vt.cs("  GET /index.html\tHTTP/1.1\r\n", &context),
+		String_Vt.cs("\t\r\n ", &context)
+	    ),
+	    &context
+	);
+	size_t length = tokens->data.array.total_size / tokens->data.array.elem_size;
+
+	printf("collected %zu tokens, last: ", length);
+	String_Vt.print(Array_Vt.at_index(tokens, length - 1));
+	printf("\n");
+    }
+
+    {
+	ltbs_byteset punctuation = Byteset_Vt.from_string(String_Vt.cs(".,;:!?", &context));
+	ltbs_cell *sentence = String_Vt.cs("A fairly long sentence without stops until here; then more!", &context);
+	size_t found = Byteset_Vt.find(&punctuation, sentence, 0);
+
+	printf("first punctuation at %zu, next at %zu\n", found, Byteset_Vt.find(&punctuation, sentence, found + 1));
+    }
+
+    {
+	ltbs_cell *body = String_Vt.cs("<item>one</item><item>two</item><item>three</item>", &context);
+	ltbs_cell *marker = String_Vt.cs("<item>", &context);
+	ltbs_cell *offsets = String_Vt.find_all(body, marker, &context);
+	size_t length = offsets->data.array.total_size / offsets->data.array.elem_size;
+
+	printf("find: %ld, rfind: %ld, count: %zu, offsets: ",
+	       String_Vt.find(body, marker, 1), String_Vt.rfind(body, marker), String_Vt.count(body, marker));
+
+	for ( size_t index = 0; index < length; index++ )
+	    printf("%lu ", *(uint64_t *) Array_Vt.at_index(offsets, index));
+
+	printf("\nreplace: ");
+	String_Vt.print(String_Vt.replace(body, marker, String_Vt.cs("<li>", &context), &context));
+	printf("\n");
+    }
+
+    {
+	// Small alphabets and needles built by repeating a short seed give
+	// the periodic needles the Two-Way path has to get right.
+	int mismatches = 0;
+
+	srand(2024);
+
+	for ( int round = 0; round < 20000; round++ )
+	{
+	    char haystack[160];
+	    char needle[80];
+	    int alphabet = 2 + rand() % 2;
+	    int haystack_length = rand() % 160;
+	    int needle_length = 1 + rand() % 79;
+	    int seed_length = 1 + rand() % 6;
+
+	    for ( int index = 0; index < haystack_length; index++ )
+		haystack[index] = (char) ('a' + rand() % alphabet);
+
+	    for ( int index = 0; index < needle_length; index++ )
+		needle[index] = (char) (index < seed_length ? 'a' + rand() % alphabet : needle[index % seed_length]);
+
+	    if ( rand() % 4 == 0 )
+		for ( int index = 0; index < needle_length; index++ )
+		    needle[index] = (char) ('a' + rand() % alphabet);
+
+	    // Plant the needle at a random spot most of the time.
+	    if ( (rand() % 3 != 0) && (needle_length <= haystack_length) )
+		memcpy(&haystack[rand() % (haystack_length - needle_length + 1)], needle, (size_t) needle_length);
+
+	    int64_t first = -1;
+	    int64_t last = -1;
+
+	    for ( int index = 0; index + needle_length <= haystack_length; index++ )
+		if ( memcmp(&haystack[index], needle, (size_t) needle_length) == 0 )
+		{
+		    if ( first < 0 ) first = index;
+		    last = index;
+		}
+
+	    ltbs_cell hay_cell = { .type = LTBS_STRING };
+	    ltbs_cell needle_cell = { .type = LTBS_STRING };
+
+	    hay_cell.data.string.strdata = haystack;
+	    hay_cell.data.string.length = (unsigned int) haystack_length;
+	    needle_cell.data.string.strdata = needle;
+	    needle_cell.data.string.length = (unsigned int) needle_length;
+
+	    mismatches += String_Vt.find(&hay_cell, &needle_cell, 0) != first;
+	    mismatches += String_Vt.rfind(&hay_cell, &needle_cell) != last;
+	}
+
+	printf("find/rfind against naive search: %d mismatches\n", mismatches);
+    }
+
     printf("Printing a formatted string...\n");
     printf("%s\n", String_Vt.format(&context, "this is an %s, %s example", "hello world", "(yet another)")->data.string.strdata);
+    printf("%s\n", String_Vt.format(
+	       &context, "%d items, %zu bytes, %lld total, 0x%x, %f%% of %S, grade %c",
+	       -3, (size_t) 4096, 9000000000LL, 255u, 0.1 + 0.2, String_Vt.cs("quota", &context), 'A'
+	   )->data.string.strdata);
+    printf("%s\n", String_Vt.format(
+	       &context, "[%5d] [%.2f] [%s] [%-6s|] [%*d] [%.*s] [%08.3f] [%+i] [%#x] [%o] [%e] [%hhd] [%3c] [%.3s]",
+	       42, 3.14159, "tail", "left", 4, 7, 3, "truncated", -2.5, 9, 255u, 8u, 12345.678, 300, 'z', (char *) 0
+	   )->data.string.strdata);
+    {
+	char expected[256];
+	snprintf(expected, sizeof(expected), "%-8.3e|%5lu|%-3zu|%.0f|%p|%5.1Lf",
+		 0.000123, 77ul, (size_t) 5, 2.5, (void *) &context, (long double) 1.25);
+	printf("matches snprintf: %d\n", strcmp(expected, String_Vt.format(
+						     &context, "%-8.3e|%5lu|%-3zu|%.0f|%p|%5.1Lf",
+						     0.000123, 77ul, (size_t) 5, 2.5, (void *) &context, (long double) 1.25
+						 )->data.string.strdata) == 0);
+    }
+
+    printf("Building a string with Builder_Vt...\n");
+    {
+	ltbs_string_builder builder = Builder_Vt.new(0, &context);
+
+	for ( int index = 0; index < 100; index++ )
+	{
+	    Builder_Vt.append_cs(&builder, "<li>");
+	    Builder_Vt.append_int(&builder, index - 50);
+	    Builder_Vt.append_cs(&builder, "</li>");
+	}
+
+	Builder_Vt.append_cell(&builder, string1);
+	Builder_Vt.append_byte(&builder, ' ');
+	Builder_Vt.append_float(&builder, 0.1);
+	Builder_Vt.append_byte(&builder, ' ');
+	Builder_Vt.append_uint(&builder, UINT64_MAX);
+	Builder_Vt.append_bytes(&builder, "\0embedded", 9);
+
+	ltbs_cell *built = Builder_Vt.finish(&builder);
+	printf("built length: %u\n", built->data.string.length);
+	String_Vt.print(built);
+	printf("\n");
+    }
+
+    printf("Inline strings\n");
+    {
+	ltbs_cell *short_key = String_Vt.cs("IA", &context);
+	ltbs_cell *edge = String_Vt.cs("fifteen bytes!!", &context);
+	ltbs_cell *long_key = String_Vt.cs("sixteen bytes!!!", &context);
+	ltbs_cell *copied = String_Vt.copy(short_key, &context);
+	ltbs_cell *array = Array_Vt.from_list(List_Vt.cons(short_key, List_Vt.cons(edge, List_Vt.nil(), &context), &context), &context);
+	ltbs_cell *first = Array_Vt.at_index(array, 0);
+
+	printf("inline: %d %d %d\n",
+	       short_key->data.string.strdata == short_key->data.string.inline_data,
+	       edge->data.string.strdata == edge->data.string.inline_data,
+	       long_key->data.string.strdata == long_key->data.string.inline_data);
+	printf("copy: %s, own bytes: %d\n", copied->data.string.strdata,
+	       copied->data.string.strdata == copied->data.string.inline_data);
+	printf("array element: %s, own bytes: %d\n", first->data.string.strdata,
+	       first->data.string.strdata == first->data.string.inline_data);
+	printf("reverse: %s\n", String_Vt.reverse(edge, &context)->data.string.strdata);
+    }
+
+    printf("Case folding and trim\n");
+    {
+	ltbs_cell *mixed = String_Vt.cs("Hello, World! [Mixed] `Case` @ 0-9 {braces} and a tail", &context);
+	ltbs_cell *upper = String_Vt.upcase(mixed, &context);
+	ltbs_cell *lower = String_Vt.downcase(mixed, &context);
+	ltbs_cell *padded = String_Vt.cs(" \t\r\n  a token with inner  spaces \v\f\n", &context);
+	ltbs_cell *blank = String_Vt.cs(" \t\n\r\v\f                      ", &context);
+	ltbs_cell view;
+
+	printf("upcase: %s\n", upper->data.string.strdata);
+	printf("downcase: %s\n", lower->data.string.strdata);
+	printf("compare_nocase: %d %d\n",
+	       String_Vt.compare_nocase(upper, lower),
+	       String_Vt.compare_nocase(upper, String_Vt.cs("HELLO, WORLD! {MIXED} `CASE` @ 0-9 {BRACES} AND A TAIL", &context)));
+	printf("compute_nocase matches upcase: %d\n",
+	       Hash_Vt.compute_nocase(&lower->data.string) == Hash_Vt.compute(&upper->data.string));
+
+	String_Vt.trim(padded, &view);
+	printf("trim: [%.*s]\n", (int) view.data.string.length, view.data.string.strdata);
+	String_Vt.trim(blank, &view);
+	printf("trim blank: %u\n", view.data.string.length);
+
+	String_Vt.downcase_in_place(upper);
+	printf("downcase_in_place: %d\n", String_Vt.compare(upper, lower));
+    }
+
+    printf("Numeric conversion\n");
+    {
+	const char *inputs[] = {
+	    "42", "-9223372036854775808", "18446744073709551615", "18446744073709551616",
+	    "+007", "3.14159", "-2.5e-3", "1e400", "0.1000000000000000055511151231257827",
+	    "4.9406564584124654e-324", "-inf", "12abc", "",
+	    // A halfway case longer than the stack copy strtod() gets.
+	    "9007199254740993.0000000000000000000000000000000000000000000000000000000000"
+	    "000000000000000000000000000000000000000000000000000000000000000000000000001", 0
+	};
+
+	for ( int index = 0; inputs[index]; index++ )
+	{
+	    ltbs_cell *text = String_Vt.cs(inputs[index], &context);
+	    int64_t as_int = 0;
+	    uint64_t as_uint = 0;
+	    double as_double = 0;
+	    int int_ok = String_Vt.to_int(text, &as_int);
+	    int uint_ok = String_Vt.to_uint(text, &as_uint);
+	    int double_ok = String_Vt.to_double(text, &as_double);
+
+	    printf("\"%s\": int %d %lld, uint %d %llu, double %d %s\n", inputs[index],
+		   int_ok, (long long) as_int, uint_ok, (unsigned long long) as_uint,
+		   double_ok, String_Vt.from_double(as_double, &context)->data.string.strdata);
+	}
+
+	printf("from_int: %s %s\n",
+	       String_Vt.from_int(INT64_MIN, &context)->data.string.strdata,
+	       String_Vt.from_uint(UINT64_MAX, &context)->data.string.strdata);
+	printf("from_double: %s %s %s\n",
+	       String_Vt.from_double(0.1, &context)->data.string.strdata,
+	       String_Vt.from_double(1e21, &context)->data.string.strdata,
+	       String_Vt.from_double(-123.456, &context)->data.string.strdata);
+    }
+
+    printf("Utf8_Vt\n");
+    {
+	ltbs_cell *text = String_Vt.cs("na\xc3\xafve caf\xc3\xa9 \xe2\x82\xac\x35 \xf0\x9f\x98\x80 and plenty of ascii after it", &context);
+	ltbs_cell *overlong = String_Vt.cs("overlong \xc0\xaf slash in a long enough string", &context);
+	ltbs_cell *surrogate = String_Vt.cs("\xed\xa0\x80", &context);
+	ltbs_cell *truncated = String_Vt.cs("a string ending in a cut sequence \xe2\x82", &context);
+
+	printf("valid: %d %d %d %d\n",
+	       Utf8_Vt.validate(text), Utf8_Vt.validate(overlong),
+	       Utf8_Vt.validate(surrogate), Utf8_Vt.validate(truncated));
+	printf("bytes: %u, code points: %zu\n", text->data.string.length, Utf8_Vt.count(text));
+
+	ltbs_utf8_iter iter = Utf8_Vt.iter(String_Vt.cs("\xc3\xa9\xe2\x82\xac\xff!", &context));
+	uint32_t codepoint;
+
+	while ( Utf8_Vt.next(&iter, &codepoint) )
+	    printf("U+%04X ", codepoint);
+	printf("\n");
+
+	ltbs_cell *wide = Utf8_Vt.to_utf32(text, &context);
+	ltbs_cell *narrow = Utf8_Vt.from_utf32(wide, &context);
+	printf("utf32 length: %zu, round trip: %d\n",
+	       wide->data.array.total_size / sizeof(uint32_t), String_Vt.compare(text, narrow));
+	printf("invalid input: %d\n", Utf8_Vt.to_utf32(overlong, &context) == 0);
+    }
 
     printf("string_from_file()");
     ltbs_cell *from_file = String_Vt.from_file("test_data/rss.htm", &context);
@@ -69,6 +326,102 @@ int main()
     }
 
     else printf("unable to read file.\n");
+
+    printf("string_map_file()\n");
+    ltbs_mapped_file mapping;
+    ltbs_cell *mapped = String_Vt.map_file("test_data/rss.htm", &mapping, &context);
+
+    if ( mapped && from_file )
+    {
+	printf("mapped length: %u, read length: %u\n",
+	       mapped->data.string.length, from_file->data.string.length);
+	printf("same contents: %d\n", String_Vt.compare(mapped, from_file));
+	String_Vt.unmap_file(&mapping);
+    }
+
+    else printf("unable to map file.\n");
+
+    printf("string_map_file_views()\n");
+    {
+	ltbs_mapped_file views_mapping;
+	ltbs_cell *views = String_Vt.map_file_views("test_data/rss.htm", &views_mapping, 7, &context);
+	size_t total = 0;
+	int oversized = 0;
+	int same = 1;
+
+	pair_iterate(views, view, _, {
+		same &= memcmp(view->data.string.strdata, from_file->data.string.strdata + total, view->data.string.length) == 0;
+		oversized += view->data.string.length > 7;
+		total += view->data.string.length;
+	    });
+
+	printf("views of at most 7 bytes: %u, oversized %d, total %zu, same contents %d\n",
+	       List_Vt.count(views), oversized, total, same);
+	String_Vt.unmap_file(&views_mapping);
+
+#ifdef LTBS_HAS_MMAP
+	// A sparse file one past UINT_MAX bytes: the single view is refused,
+	// the views split exactly at the boundary. Nothing is ever read.
+	char sparse_path[] = "/tmp/ltbs_sparse_XXXXXX";
+	int fd = mkstemp(sparse_path);
+
+	if ( (fd >= 0) && (ftruncate(fd, (off_t) UINT_MAX + 1) == 0) )
+	{
+	    ltbs_mapped_file large_mapping;
+
+	    printf("map_file refuses %zu bytes: %d\n", (size_t) UINT_MAX + 1,
+		   String_Vt.map_file(sparse_path, &large_mapping, &context) == 0);
+
+	    views = String_Vt.map_file_views(sparse_path, &large_mapping, 0, &context);
+
+	    if ( views )
+	    {
+		printf("views: %u, first %u, last %u\n", List_Vt.count(views),
+		       pair_head(views)->data.string.length,
+		       pair_head(pair_rest(views))->data.string.length);
+		String_Vt.unmap_file(&large_mapping);
+	    }
+	}
+
+	if ( fd >= 0 )
+	{
+	    close(fd);
+	    unlink(sparse_path);
+	}
+#endif
+    }
+
+    printf("Reader_Vt\n");
+    {
+	// A small chunk size makes most lines straddle two reads.
+	ltbs_file_reader *reader = Reader_Vt.open("test_data/rss.htm", 64, &context);
+	ltbs_cell line;
+	size_t lines = 0;
+	size_t bytes = 0;
+
+	while ( reader && Reader_Vt.next_line(reader, &line) )
+	{
+	    lines++;
+	    bytes += line.data.string.length + 1;
+	}
+
+	if ( reader ) Reader_Vt.close(reader);
+	printf("lines: %zu, bytes with newlines: %zu\n", lines, bytes);
+
+	reader = Reader_Vt.open("test_data/rss.htm", 1000, &context);
+	ltbs_cell chunk;
+	size_t chunks = 0;
+	bytes = 0;
+
+	while ( reader && Reader_Vt.next_chunk(reader, &chunk) )
+	{
+	    chunks++;
+	    bytes += chunk.data.string.length;
+	}
+
+	if ( reader ) Reader_Vt.close(reader);
+	printf("chunks: %zu, bytes: %zu\n", chunks, bytes);
+    }
     
     arena_free(&context);
     return 0;